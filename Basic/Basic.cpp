@@ -4,237 +4,983 @@
  * This file is the starter project for the BASIC interpreter.
  */
 
+#include <algorithm>
 #include <cctype>
+#include <cstdlib>
 #include <iostream>
+#include <new>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "cache.hpp"
 #include "exp.hpp"
+#include "memory.hpp"
 #include "parser.hpp"
 #include "program.hpp"
 #include "Utils/error.hpp"
-#include "Utils/tokenScanner.hpp"
+#include "Utils/inputBuffer.hpp"
+#include "Utils/lexer.hpp"
+#include "Utils/mappedFile.hpp"
+#include "Utils/outputBuffer.hpp"
 #include "Utils/strlib.hpp"
 
 
 /* Function prototypes */
 
-void processLine(std::string line, Program &program, EvalState &state);
+void processLine(const std::string &line, Program &program, EvalState &state);
+
+void executeLine(const std::string &line, Program &program, EvalState &state);
+
+void loadProgram(std::string_view text, Program &program, EvalState &state);
+
+bool parseOptions(int argc, char *argv[]);
+
+void parseStoredLine(std::string_view line, Statement &stmt);
+
+/*
+ * Constant: RECLAIM_BUDGET
+ * ------------------------
+ * The number of lines and variables left behind by CLEAR that are
+ * freed after each command, which spreads the cost of tearing down
+ * a large program over the commands that follow.  When a memory quota
+ * is set and more than half of it is in use, everything is freed at
+ * once so that the memory is available to the next command.
+ */
+
+const int RECLAIM_BUDGET = 1024;
+
+/*
+ * Variable: lazyParsing
+ * ---------------------
+ * Set by the --lazy option.  In lazy mode a numbered line is only
+ * checked for syntax when it is entered, and it is parsed the first
+ * time RUN reaches it.
+ */
+
+static bool lazyParsing = false;
+
+/*
+ * Variable: loadFile
+ * ------------------
+ * The file named on the command line or by the --load option, which
+ * is loaded with loadProgram before the first line is read from the
+ * user.
+ */
+
+static std::string loadFile;
+
+/*
+ * Variable: runLoaded
+ * -------------------
+ * Set by the --run option.
+ */
+
+static bool runLoaded = false;
+
+/*
+ * Variable: headless
+ * ------------------
+ * Set by the --headless option.
+ */
+
+static bool headless = false;
+
+/*
+ * Variable: prefetch
+ * ------------------
+ * Set by the --prefetch option.
+ */
+
+static bool prefetch = false;
+
+/*
+ * Variable: asyncOutput
+ * ---------------------
+ * Set by the --async-output option.
+ */
+
+static bool asyncOutput = false;
+
+/*
+ * Constant: ASYNC_OUTPUT_CHUNKS
+ * -----------------------------
+ * The number of full output buffers that may wait for the writer
+ * thread before the interpreter has to wait for it.
+ */
+
+const std::size_t ASYNC_OUTPUT_CHUNKS = 16;
+
+/*
+ * Constant: PREFETCH_BLOCKS
+ * -------------------------
+ * The number of blocks of input the prefetch thread may read ahead.
+ */
+
+const std::size_t PREFETCH_BLOCKS = 16;
+
+/*
+ * Constant: PARSE_CACHE_ENTRIES
+ * -----------------------------
+ * The number of statements kept in the parse cache.  Programs that
+ * are typed or pasted in often repeat the same statement on many
+ * lines, and a numbered line whose statement text is in the cache is
+ * stored without being tokenized or parsed again.
+ */
+
+const std::size_t PARSE_CACHE_ENTRIES = 4096;
+
+static ParseCache parseCache(PARSE_CACHE_ENTRIES);
 
 /* Main program */
 
-int main() {
+int main(int argc, char *argv[]) {
+    if (!parseOptions(argc, argv))
+        return 1;
     EvalState state;
     Program program;
+    program.setLineParser(parseStoredLine);
+    bool interactive = isatty(STDIN_FILENO);
+    standardOutput().setLineBuffered(isatty(STDOUT_FILENO));
+    state.setPrompting(!headless || interactive);
+    if (prefetch) standardInput().startPrefetch(PREFETCH_BLOCKS);
+    if (asyncOutput) standardOutput().startWriter(ASYNC_OUTPUT_CHUNKS);
+    if (!loadFile.empty()) {
+        MappedFile file(loadFile);
+        if (!file.isOpen()) {
+            std::cerr << argv[0] << ": cannot open " << loadFile << std::endl;
+            return 1;
+        }
+        loadProgram(file.getText(), program, state);
+    }
+    if (runLoaded) {
+        executeLine("RUN", program, state);
+        return 0;
+    }
     //cout << "Stub implementation of BASIC" << endl;
+    std::string input;
     while (true) {
-        try {
-            std::string input;
-            getline(std::cin, input);
-            if (input.empty())
-                return 0;
-            processLine(input, program, state);
-        } catch (ErrorException &ex) {
-            std::cout << ex.getMessage() << std::endl;
-        }
+        std::string_view line;
+        if (!standardInput().isLineReady()) standardOutput().sync();
+        standardInput().readLine(line);
+        if (line.empty())
+            return 0;
+        input.assign(line);
+        executeLine(input, program, state);
     }
     return 0;
 }
 
 /*
- * Function: processLine
- * Usage: processLine(line, program, state);
+ * Function: executeLine
+ * Usage: executeLine(line, program, state);
  * -----------------------------------------
- * Processes a single line entered by the user.  In this version of
- * implementation, the program reads a line, parses it as an expression,
- * and then prints the result.  In your implementation, you will
- * need to replace this method with one that can respond correctly
- * when the user enters a program line (which begins with a number)
- * or one of the BASIC commands, such as LIST or RUN.
- */
-
-void processLine(std::string line, Program &program, EvalState &state) {
-    TokenScanner scanner;
-    scanner.ignoreWhitespace();
-    scanner.scanNumbers();
-    scanner.setInput(line);
-    std::string token;
-    int lineNumber;
-    Statement *stmt;
-    if (scanner.hasMoreTokens()) {
-        token = scanner.nextToken();
-        if (scanner.getTokenType(token) == NUMBER) {
-            lineNumber = stringToInteger(token);
-            if (!scanner.hasMoreTokens()) {
-                program.removeSourceLine(lineNumber);
-                return;
-            }
-            token = scanner.nextToken();
-            if (token == "REM") {
-                stmt = new RemStmt;
-            } else if (token == "LET") {
-                Expression *tmpExp = readE(scanner);
-                if (scanner.hasMoreTokens()) {
-                    std::cout << "SYNTAX ERROR\n";
-                    return;
-                }
-                stmt = new LetStmt(tmpExp);
-            } else if (token == "INPUT") {
-                Expression *val = readT(scanner);
-                if (scanner.hasMoreTokens()) {
-                    std::cout << "SYNTAX ERROR\n";
-                    return;
-                }
-                stmt = new InputStmt((IdentifierExp *)val);
-            } else if (token == "PRINT") {
-                Expression *tmpExp = readE(scanner, 1);
-                if (scanner.hasMoreTokens()) {
-                    std::cout << "SYNTAX ERROR\n";
-                    return;
-                }
-                stmt = new PrintStmt(tmpExp);
-            } else if (token == "END") {
-                if (scanner.hasMoreTokens()) {
-                    std::cout << "SYNTAX ERROR\n";
-                    return;
-                }
-                stmt = new EndStmt;
-            } else if (token == "IF") {
-                Expression *lhs = readE(scanner, 1);
-                std::string cmp = scanner.nextToken();
-                if (cmp != "<" && cmp != ">" && cmp != "=") {
-                    std::cout << "SYNTAX ERROR\n";
-                    return;
-                }
-                Expression *rhs = readE(scanner, 1);
-                if (scanner.nextToken() != "THEN") {
-                    std::cout << "SYNTAX ERROR\n";
-                    return;
-                }
-                token = scanner.nextToken();
-                if (scanner.getTokenType(token) != NUMBER) {
-                    std::cout << "SYNTAX ERROR\n";
-                    return;
-                }
-                if (scanner.hasMoreTokens()) {
-                    std::cout << "SYNTAX ERROR\n";
-                    return;
-                }
-                stmt = new IfStmt(lhs, cmp, rhs, stringToInteger(token));
-            } else if (token == "GOTO") {
-                token = scanner.nextToken();
-                if (scanner.getTokenType(token) != NUMBER) {
-                    std::cout << "SYNTAX ERROR\n";
-                    return;
-                }
-                if (scanner.hasMoreTokens()) {
-                    std::cout << "SYNTAX ERROR\n";
-                    return;
-                }
-                stmt = new GoToStmt(stringToInteger(token));
-            } else {
-                std::cout << "SYNTAX ERROR\n";
-                return;
-            }
-            program.addSourceLine(lineNumber, line);
-            program.setParsedStatement(lineNumber, stmt);
-        } else if (scanner.getTokenType(token) == WORD) {
-            if (token == "LET") {
-                Expression *tmpExp = readE(scanner);
-                if (scanner.hasMoreTokens()) {
-                    std::cout << "SYNTAX ERROR\n";
-                    return;
-                }
-                Statement *letStmt;
-                letStmt = new LetStmt(tmpExp);
-                program.addTemporaryLine(letStmt);
-                letStmt->execute(state, program);
-                return;
-            }
-            if (token == "INPUT") {
-                Expression *val = readT(scanner);
-                if (scanner.hasMoreTokens()) {
-                    std::cout << "SYNTAX ERROR\n";
-                    return;
-                }
-                Statement *inputStmt;
-                inputStmt = new InputStmt((IdentifierExp *)val);
-                program.addTemporaryLine(inputStmt);
-                inputStmt->execute(state, program);
-                return;
-            }
-            if (token == "PRINT") {
-                Expression *tmpExp = readE(scanner, 1);
-                if (scanner.hasMoreTokens()) {
-                    std::cout << "SYNTAX ERROR\n";
-                    return;
-                }
-                Statement *printStmt;
-                printStmt = new PrintStmt(tmpExp);
-                program.addTemporaryLine(printStmt);
-                printStmt->execute(state, program);
-                return;
-            }
-            if (token == "RUN") {
-                if (scanner.hasMoreTokens()) {
-                    std::cout << "SYNTAX ERROR\n";
-                    return;
-                }
-                Statement *runStmt;
-                runStmt = new RunStmt;
-                program.addTemporaryLine(runStmt);
-                runStmt->execute(state, program);
-                return;
-            }
-            if (token == "LIST") {
-                if (scanner.hasMoreTokens()) {
-                    std::cout << "SYNTAX ERROR\n";
-                    return;
-                }
-                Statement *listStmt;
-                listStmt = new ListStmt;
-                listStmt->execute(state, program);
-                delete listStmt;
-                return;
-            }
-            if (token == "HELP") {
-                if (scanner.hasMoreTokens()) {
-                    std::cout << "SYNTAX ERROR\n";
-                    return;
-                }
-                Statement *helpStmt;
-                helpStmt = new HelpStmt;
-                helpStmt->execute(state, program);
-                delete helpStmt;
-                return;
+ * Processes one line as a command of its own: an error raised while
+ * processing the line is reported, and storage left behind by CLEAR
+ * is reclaimed afterwards.
+ */
+
+void executeLine(const std::string &line, Program &program, EvalState &state) {
+    try {
+        processLine(line, program, state);
+    } catch (ErrorException &ex) {
+        standardOutput() << ex.getMessage() << '\n';
+        standardOutput().flush();
+    }
+    std::size_t quota = getMemoryQuota();
+    int budget = (quota != 0 && getMemoryUsage() > quota / 2) ? -1 : RECLAIM_BUDGET;
+    if (budget < 0) parseCache.clear();
+    program.reclaim(budget);
+    state.reclaim(budget);
+}
+
+/*
+ * Function: parseOptions
+ * Usage: if (!parseOptions(argc, argv)) return 1;
+ * -----------------------------------------------
+ * Applies the command-line options, which are:
+ *
+ *   --memory-quota=BYTES   Limits the memory owned by the interpreter
+ *                          to BYTES, which may end in K, M or G.  An
+ *                          allocation beyond the quota is reported as
+ *                          OUT OF MEMORY.
+ *
+ *   --lazy                 Only checks the syntax of numbered lines
+ *                          when they are entered and parses each line
+ *                          the first time it is executed.  The lines
+ *                          that are accepted and the errors reported
+ *                          are the same as without this option.
+ *
+ *   --load=FILE            Loads FILE with loadProgram before reading
+ *                          commands from the standard input.  FILE may
+ *                          also be given on its own, without --load=.
+ *
+ *   --run                  Runs the loaded program and exits instead
+ *                          of reading commands, so that the standard
+ *                          input only supplies the answers to INPUT.
+ *                          It implies --lazy, since only the lines the
+ *                          program reaches ever need to be parsed.
+ *
+ *   --headless             Leaves out the " ? " prompt of INPUT when
+ *                          the standard input is not a terminal, for
+ *                          programs that are fed data by other
+ *                          programs.  Error messages such as INVALID
+ *                          NUMBER are still printed.
+ *
+ *   --prefetch             Reads the standard input on a separate
+ *                          thread, which keeps the next lines ready
+ *                          while the interpreter is busy.  Commands
+ *                          and answers to INPUT are read exactly as
+ *                          without this option.
+ *
+ *   --async-output         Writes the standard output on a separate
+ *                          thread, so that the interpreter goes on
+ *                          while a slow reader catches up.  The output
+ *                          is the same and in the same order, and it
+ *                          is complete before INPUT waits for an
+ *                          answer.
+ *
+ * If an option is not recognized, if more than one file is given or
+ * if --run is given without a file, a usage message is printed to
+ * std::cerr and the function returns false.
+ */
+
+/*
+ * Function: printUsage
+ * Usage: return printUsage(argv[0]);
+ * ----------------------------------
+ * Prints the usage message to std::cerr and returns false.
+ */
+
+static bool printUsage(const char *name) {
+    std::cerr << "usage: " << name << " [--memory-quota=BYTES] [--lazy] [--headless] [--prefetch]"
+              << " [--async-output] [--run] [[--load=]FILE]" << std::endl;
+    return false;
+}
+
+bool parseOptions(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (startsWith(option, "--memory-quota=")) {
+            const char *value = option.c_str() + 15;
+            char *end;
+            unsigned long long bytes = std::strtoull(value, &end, 10);
+            if (*end == 'K') bytes <<= 10, end++;
+            else if (*end == 'M') bytes <<= 20, end++;
+            else if (*end == 'G') bytes <<= 30, end++;
+            if (end != value && *end == '\0' && isdigit(*value)) {
+                setMemoryQuota(bytes);
+                continue;
             }
-            if (token == "CLEAR") {
-                if (scanner.hasMoreTokens()) {
-                    std::cout << "SYNTAX ERROR\n";
-                    return;
-                }
-                Statement *clearStmt;
-                clearStmt = new ClearStmt;
-                clearStmt->execute(state, program);
-                delete clearStmt;
-                return;
+        }
+        if (option == "--headless") {
+            headless = true;
+            continue;
+        }
+        if (option == "--prefetch") {
+            prefetch = true;
+            continue;
+        }
+        if (option == "--async-output") {
+            asyncOutput = true;
+            continue;
+        }
+        if (option == "--lazy") {
+            lazyParsing = true;
+            continue;
+        }
+        if (option == "--run") {
+            runLoaded = true;
+            continue;
+        }
+        if (loadFile.empty()) {
+            if (startsWith(option, "--load=") && option.length() > 7) {
+                loadFile = option.substr(7);
+                continue;
             }
-            if (token == "QUIT") {
-                if (scanner.hasMoreTokens()) {
-                    std::cout << "SYNTAX ERROR\n";
-                    return;
-                }
-                Statement *quitStmt;
-                quitStmt = new QuitStmt;
-                quitStmt->execute(state, program);
-                delete quitStmt;
-                exit(0);
+            if (!option.empty() && option[0] != '-') {
+                loadFile = option;
+                continue;
             }
-            std::cout << "SYNTAX ERROR\n";
-        } else {
-            std::cout << "SYNTAX ERROR\n";
         }
+        return printUsage(argv[0]);
+    }
+    if (runLoaded) {
+        if (loadFile.empty()) return printUsage(argv[0]);
+        lazyParsing = true;
+    }
+    return true;
+}
+
+/*
+ * Command table
+ * -------------
+ * Every keyword that can start a line has an entry in COMMANDS, which
+ * records whether the command may be used in a numbered program line,
+ * as an immediate command, or both.  Commands that can be stored in a
+ * program have a parse function, which reads the rest of the line into
+ * a Statement and returns false if the line is not well formed; in
+ * immediate mode the parsed statement is executed at once.  They also
+ * have a check function, which accepts and rejects exactly the same
+ * lines, and raises the same errors, without building the statement.
+ * Commands that exist only in immediate mode have a run function
+ * instead, which returns false if the line is not well formed.  LET
+ * and PRINT have a run function as well, which computes the value of
+ * the expression as it reads it; in immediate mode it is used instead
+ * of the parse function, except that PRINT to a file is parsed and
+ * executed like the other statements.  Either way a false result is
+ * reported as SYNTAX ERROR.
+ *
+ * Keywords are looked up through a perfect hash: hashKeyword maps each
+ * of them to a different slot of COMMAND_SLOTS, which is built at
+ * compile time, so finding a command costs one hash and one string
+ * comparison.  Adding a command only takes a new entry in COMMANDS; if
+ * its keyword collides with another one, the static_assert below fails
+ * and the constants in hashKeyword must be changed.
+ */
+
+enum CommandModes {
+    PROGRAM_MODE = 1,
+    IMMEDIATE_MODE = 2
+};
+
+typedef bool (*StatementParser)(TokenArray &tokens, Statement &stmt);
+
+typedef bool (*StatementChecker)(TokenArray &tokens);
+
+typedef bool (*CommandRunner)(TokenArray &tokens, Program &program, EvalState &state);
+
+struct Command {
+    std::string_view name;
+    int modes;
+    StatementParser parse;
+    StatementChecker check;
+    CommandRunner run;
+};
+
+/*
+ * Functions: readChannel, readOpen, readClose
+ * -------------------------------------------
+ * Read the operands of the file statements, which are shared by their
+ * parse and check functions.  A channel is written as '#' followed by
+ * a number between 1 and EvalState::MAX_CHANNELS.  CLOSE without a
+ * channel reads as channel 0, which closes every file.
+ */
+
+static bool readChannel(TokenArray &tokens, int &channel) {
+    if (tokens.nextToken() != "#") return false;
+    std::string_view token = tokens.nextToken();
+    if (tokens.getTokenKind(token) != LEX_NUMBER) return false;
+    channel = stringToInteger(token);
+    return channel >= 1 && channel <= EvalState::MAX_CHANNELS;
+}
+
+static bool readOpen(TokenArray &tokens, std::string_view &path, FileMode &mode, int &channel) {
+    if (!tokens.readString(path) || tokens.nextToken() != "FOR") return false;
+    std::string_view name = tokens.nextToken();
+    if (name == "INPUT") {
+        mode = FILE_INPUT;
+    } else if (name == "OUTPUT") {
+        mode = FILE_OUTPUT;
+    } else if (name == "APPEND") {
+        mode = FILE_APPEND;
     } else {
+        return false;
+    }
+    return tokens.nextToken() == "AS" && readChannel(tokens, channel) && !tokens.hasMoreTokens();
+}
+
+static bool readClose(TokenArray &tokens, int &channel) {
+    channel = 0;
+    if (!tokens.hasMoreTokens()) return true;
+    return readChannel(tokens, channel) && !tokens.hasMoreTokens();
+}
+
+static bool parseRem(TokenArray &, Statement &stmt) {
+    stmt = RemStmt();
+    return true;
+}
+
+static bool parseLet(TokenArray &tokens, Statement &stmt) {
+    std::unique_ptr<Expression> exp = readE(tokens);
+    if (tokens.hasMoreTokens()) return false;
+    stmt = LetStmt(std::move(exp));
+    return true;
+}
+
+static bool parsePrint(TokenArray &tokens, Statement &stmt) {
+    if (tokens.peekToken() == "#") {
+        int channel;
+        if (!readChannel(tokens, channel) || tokens.nextToken() != ",") return false;
+        std::unique_ptr<Expression> exp = readE(tokens, 1);
+        if (tokens.hasMoreTokens()) return false;
+        stmt = PrintFileStmt(channel, std::move(exp));
+        return true;
+    }
+    std::unique_ptr<Expression> exp = readE(tokens, 1);
+    if (tokens.hasMoreTokens()) return false;
+    stmt = PrintStmt(std::move(exp));
+    return true;
+}
+
+static bool parseInput(TokenArray &tokens, Statement &stmt) {
+    if (tokens.peekToken() == "#") {
+        int channel;
+        if (!readChannel(tokens, channel) || tokens.nextToken() != ",") return false;
+        std::unique_ptr<Expression> val = readT(tokens);
+        if (val->getType() != IDENTIFIER || tokens.hasMoreTokens()) return false;
+        stmt = InputFileStmt(channel, std::unique_ptr<IdentifierExp>((IdentifierExp *) val.release()));
+        return true;
+    }
+    std::unique_ptr<Expression> val = readT(tokens);
+    if (val->getType() != IDENTIFIER || tokens.hasMoreTokens()) return false;
+    stmt = InputStmt(std::unique_ptr<IdentifierExp>((IdentifierExp *) val.release()));
+    return true;
+}
+
+static bool parseEnd(TokenArray &tokens, Statement &stmt) {
+    if (tokens.hasMoreTokens()) return false;
+    stmt = EndStmt();
+    return true;
+}
+
+static bool parseGoto(TokenArray &tokens, Statement &stmt) {
+    std::string_view token = tokens.nextToken();
+    if (tokens.getTokenKind(token) != LEX_NUMBER || tokens.hasMoreTokens()) return false;
+    stmt = GoToStmt(stringToInteger(token));
+    return true;
+}
+
+static bool parseIf(TokenArray &tokens, Statement &stmt) {
+    std::unique_ptr<Expression> lhs = readE(tokens, 1);
+    std::string_view cmp = tokens.nextToken();
+    if (cmp != "<" && cmp != ">" && cmp != "=") return false;
+    std::unique_ptr<Expression> rhs = readE(tokens, 1);
+    if (tokens.nextToken() != "THEN") return false;
+    std::string_view token = tokens.nextToken();
+    if (tokens.getTokenKind(token) != LEX_NUMBER || tokens.hasMoreTokens()) return false;
+    stmt = IfStmt(std::move(lhs), cmp[0], std::move(rhs), stringToInteger(token));
+    return true;
+}
+
+static bool parseOpen(TokenArray &tokens, Statement &stmt) {
+    std::string_view path;
+    FileMode mode;
+    int channel;
+    if (!readOpen(tokens, path, mode, channel)) return false;
+    stmt = OpenStmt(std::string(path), mode, channel);
+    return true;
+}
+
+static bool parseClose(TokenArray &tokens, Statement &stmt) {
+    int channel;
+    if (!readClose(tokens, channel)) return false;
+    stmt = CloseStmt(channel);
+    return true;
+}
+
+static bool checkRem(TokenArray &) {
+    return true;
+}
+
+static bool checkLet(TokenArray &tokens) {
+    checkE(tokens);
+    return !tokens.hasMoreTokens();
+}
+
+static bool checkPrint(TokenArray &tokens) {
+    int channel;
+    if (tokens.peekToken() == "#" && (!readChannel(tokens, channel) || tokens.nextToken() != ",")) return false;
+    checkE(tokens, 1);
+    return !tokens.hasMoreTokens();
+}
+
+static bool checkInput(TokenArray &tokens) {
+    int channel;
+    if (tokens.peekToken() == "#" && (!readChannel(tokens, channel) || tokens.nextToken() != ",")) return false;
+    return checkT(tokens) == IDENTIFIER && !tokens.hasMoreTokens();
+}
+
+static bool checkEnd(TokenArray &tokens) {
+    return !tokens.hasMoreTokens();
+}
+
+static bool checkGoto(TokenArray &tokens) {
+    std::string_view token = tokens.nextToken();
+    if (tokens.getTokenKind(token) != LEX_NUMBER || tokens.hasMoreTokens()) return false;
+    stringToInteger(token);
+    return true;
+}
+
+static bool checkIf(TokenArray &tokens) {
+    checkE(tokens, 1);
+    std::string_view cmp = tokens.nextToken();
+    if (cmp != "<" && cmp != ">" && cmp != "=") return false;
+    checkE(tokens, 1);
+    if (tokens.nextToken() != "THEN") return false;
+    std::string_view token = tokens.nextToken();
+    if (tokens.getTokenKind(token) != LEX_NUMBER || tokens.hasMoreTokens()) return false;
+    stringToInteger(token);
+    return true;
+}
+
+static bool checkOpen(TokenArray &tokens) {
+    std::string_view path;
+    FileMode mode;
+    int channel;
+    return readOpen(tokens, path, mode, channel);
+}
+
+static bool checkClose(TokenArray &tokens) {
+    int channel;
+    return readClose(tokens, channel);
+}
+
+/*
+ * Variable: immediateEvaluator
+ * ----------------------------
+ * The evaluator used by runLet and runPrint.  It is kept from one
+ * command to the next so that its storage is reused.
+ */
+
+static DirectEvaluator immediateEvaluator;
+
+static bool runLet(TokenArray &tokens, Program &, EvalState &state) {
+    immediateEvaluator.evaluate(tokens, state);
+    if (tokens.hasMoreTokens()) return false;
+    immediateEvaluator.commit(state);
+    return true;
+}
+
+static bool runPrint(TokenArray &tokens, Program &program, EvalState &state) {
+    if (tokens.peekToken() == "#") {
+        Statement stmt;
+        if (!parsePrint(tokens, stmt)) return false;
+        executeStatement(stmt, state, program);
+        return true;
+    }
+    int value = immediateEvaluator.evaluate(tokens, state, 1);
+    if (tokens.hasMoreTokens()) return false;
+    immediateEvaluator.commit(state);
+    standardOutput() << value << '\n';
+    return true;
+}
+
+template<typename CommandType>
+static bool runCommand(TokenArray &tokens, Program &program, EvalState &state) {
+    if (tokens.hasMoreTokens()) return false;
+    CommandType command;
+    command.execute(state, program);
+    return true;
+}
+
+static bool runStats(TokenArray &tokens, Program &program, EvalState &state) {
+    bool json = false;
+    if (tokens.hasMoreTokens()) {
+        json = (tokens.nextToken() == "JSON");
+        if (!json || tokens.hasMoreTokens()) return false;
+    }
+    StatsStmt statsStmt(json, parseCache);
+    statsStmt.execute(state, program);
+    return true;
+}
+
+static bool runQuit(TokenArray &tokens, Program &program, EvalState &state) {
+    if (tokens.hasMoreTokens()) return false;
+    QuitStmt quitStmt;
+    quitStmt.execute(state, program);
+    exit(0);
+}
+
+static constexpr Command COMMANDS[] = {
+    {"REM",   PROGRAM_MODE,                  parseRem,   checkRem,   nullptr},
+    {"LET",   PROGRAM_MODE | IMMEDIATE_MODE, parseLet,   checkLet,   runLet},
+    {"PRINT", PROGRAM_MODE | IMMEDIATE_MODE, parsePrint, checkPrint, runPrint},
+    {"INPUT", PROGRAM_MODE | IMMEDIATE_MODE, parseInput, checkInput, nullptr},
+    {"END",   PROGRAM_MODE,                  parseEnd,   checkEnd,   nullptr},
+    {"GOTO",  PROGRAM_MODE,                  parseGoto,  checkGoto,  nullptr},
+    {"IF",    PROGRAM_MODE,                  parseIf,    checkIf,    nullptr},
+    {"OPEN",  PROGRAM_MODE | IMMEDIATE_MODE, parseOpen,  checkOpen,  nullptr},
+    {"CLOSE", PROGRAM_MODE | IMMEDIATE_MODE, parseClose, checkClose, nullptr},
+    {"RUN",   IMMEDIATE_MODE,                nullptr,    nullptr,    runCommand<RunStmt>},
+    {"LIST",  IMMEDIATE_MODE,                nullptr,    nullptr,    runCommand<ListStmt>},
+    {"HELP",  IMMEDIATE_MODE,                nullptr,    nullptr,    runCommand<HelpStmt>},
+    {"CLEAR", IMMEDIATE_MODE,                nullptr,    nullptr,    runCommand<ClearStmt>},
+    {"STATS", IMMEDIATE_MODE,                nullptr,    nullptr,    runStats},
+    {"QUIT",  IMMEDIATE_MODE,                nullptr,    nullptr,    runQuit},
+};
+
+static const int COMMAND_COUNT = sizeof COMMANDS / sizeof COMMANDS[0];
+
+static const int HASH_SLOTS = 32;
+
+static constexpr int hashKeyword(std::string_view word) {
+    return (int(word.length()) + 3 * (unsigned char) word.front() + (unsigned char) word.back()) % HASH_SLOTS;
+}
+
+struct CommandSlots {
+    int index[HASH_SLOTS];
+    bool perfect;
+};
+
+static constexpr CommandSlots buildCommandSlots() {
+    CommandSlots slots = {{}, true};
+    for (int &index: slots.index) {
+        index = -1;
+    }
+    for (int i = 0; i < COMMAND_COUNT; i++) {
+        int &index = slots.index[hashKeyword(COMMANDS[i].name)];
+        if (index != -1) slots.perfect = false;
+        index = i;
+    }
+    return slots;
+}
+
+static constexpr CommandSlots COMMAND_SLOTS = buildCommandSlots();
+
+static_assert(COMMAND_SLOTS.perfect, "two keywords share a slot: change the constants in hashKeyword");
+
+/*
+ * Function: findCommand
+ * Usage: const Command *command = findCommand(token);
+ * ---------------------------------------------------
+ * Returns the entry of the command named by token, or nullptr if the
+ * token is not a keyword.
+ */
+
+static const Command *findCommand(std::string_view token) {
+    if (token.empty()) return nullptr;
+    int index = COMMAND_SLOTS.index[hashKeyword(token)];
+    if (index == -1 || COMMANDS[index].name != token) return nullptr;
+    return &COMMANDS[index];
+}
+
+/*
+ * Type: NumberedLine
+ * ------------------
+ * The outcome of reading a numbered line, which storeNumberedLine
+ * then applies to the program.  Splitting the two steps lets
+ * loadProgram read many lines at once on several threads while still
+ * changing the program, and printing messages, one line at a time.
+ */
+
+struct NumberedLine {
+    enum Action {
+        ADD,            /* Store stmt under lineNumber          */
+        ADD_UNPARSED,   /* Store the text only (lazy mode)      */
+        REMOVE,         /* The line holds only its number       */
+        REJECT,         /* Print SYNTAX ERROR                   */
+        FAIL            /* Print the error message              */
+    };
+    Action action = REJECT;
+    int lineNumber = 0;
+    std::string_view text;
+    Statement stmt;
+    std::string message;
+};
+
+/*
+ * Function: parseNumberedLine
+ * Usage: parseNumberedLine(tokens, lineNumber, line);
+ * ---------------------------------------------------
+ * Reads the rest of a numbered line, whose number has already been
+ * read from tokens, into line.  Errors raised by the parser are passed
+ * on to the caller.  This function has no effect on the program or on
+ * the output, so it may run on any thread.
+ */
+
+static void parseNumberedLine(TokenArray &tokens, int lineNumber, NumberedLine &line) {
+    line.lineNumber = lineNumber;
+    line.action = NumberedLine::REJECT;
+    if (!tokens.hasMoreTokens()) {
+        line.action = NumberedLine::REMOVE;
         return;
     }
+    const Command *command = findCommand(tokens.nextToken());
+    if (command == nullptr || !(command->modes & PROGRAM_MODE)) return;
+    if (lazyParsing) {
+        if (command->check(tokens)) line.action = NumberedLine::ADD_UNPARSED;
+        return;
+    }
+    if (command->parse(tokens, line.stmt)) line.action = NumberedLine::ADD;
+}
+
+/*
+ * Function: storeNumberedLine
+ * Usage: storeNumberedLine(line, program);
+ * ----------------------------------------
+ * Applies the outcome of parseNumberedLine to the program.
+ */
+
+static void storeNumberedLine(NumberedLine &line, Program &program) {
+    switch (line.action) {
+        case NumberedLine::ADD:
+            program.addSourceLine(line.lineNumber, line.text, std::move(line.stmt));
+            break;
+        case NumberedLine::ADD_UNPARSED:
+            program.addUnparsedLine(line.lineNumber, line.text);
+            break;
+        case NumberedLine::REMOVE:
+            program.removeSourceLine(line.lineNumber);
+            break;
+        case NumberedLine::REJECT:
+            standardOutput() << "SYNTAX ERROR\n";
+            break;
+        case NumberedLine::FAIL:
+            standardOutput() << line.message << '\n';
+            standardOutput().flush();
+            break;
+    }
+}
+
+/*
+ * Function: splitLineNumber
+ * Usage: if (splitLineNumber(line, number, body)) ...
+ * ---------------------------------------------------
+ * Splits a line made of a line number and a statement into the digits
+ * of the number and the text after them.  Returns false for any other
+ * line, and also when the digits are followed by '.', 'E' or 'e',
+ * which the scanner would read as part of the number.  The tokens of
+ * the body are then the tokens of the line after the number, so the
+ * body alone decides the statement.
+ */
 
+static bool splitLineNumber(std::string_view line, std::string_view &number, std::string_view &body) {
+    std::size_t start = line.find_first_not_of(" \t\n\v\f\r");
+    if (start == std::string_view::npos || !isdigit((unsigned char) line[start])) return false;
+    std::size_t end = start + 1;
+    while (end < line.size() && isdigit((unsigned char) line[end])) end++;
+    if (end < line.size() && (line[end] == '.' || line[end] == 'E' || line[end] == 'e')) return false;
+    body = line.substr(end);
+    if (body.find_first_not_of(" \t\n\v\f\r") == std::string_view::npos) return false;
+    number = line.substr(start, end - start);
+    return true;
 }
 
+/*
+ * Function: processLine
+ * Usage: processLine(line, program, state);
+ * -----------------------------------------
+ * Processes a single line entered by the user.  A line that begins
+ * with a number is stored in the program under that line number, or
+ * deletes the line if nothing follows the number.  Any other line is
+ * an immediate command and is executed at once.  In both cases the
+ * keyword is looked up in the command table above.  The statement of
+ * a numbered line is first looked up in the parse cache, and a newly
+ * parsed one is added to it.
+ */
+
+void processLine(const std::string &line, Program &program, EvalState &state) {
+    std::string_view number, body;
+    bool cacheable = !lazyParsing && splitLineNumber(line, number, body);
+    if (cacheable) {
+        if (const Statement *stmt = parseCache.lookup(body)) {
+            NumberedLine numbered;
+            numbered.text = line;
+            numbered.lineNumber = stringToInteger(number);
+            numbered.action = NumberedLine::ADD;
+            numbered.stmt = *stmt;
+            storeNumberedLine(numbered, program);
+            return;
+        }
+    }
+    TokenArray tokens;
+    tokens.setInput(line);
+    if (!tokens.hasMoreTokens()) return;
+    std::string_view token = tokens.nextToken();
+    LexemeKind kind = tokens.getTokenKind(token);
+    if (kind == LEX_NUMBER) {
+        NumberedLine numbered;
+        numbered.text = line;
+        parseNumberedLine(tokens, stringToInteger(token), numbered);
+        if (cacheable && numbered.action == NumberedLine::ADD) {
+            parseCache.insert(body, numbered.stmt);
+        }
+        storeNumberedLine(numbered, program);
+        return;
+    }
+    const Command *command = (kind == LEX_WORD) ? findCommand(token) : nullptr;
+    if (command == nullptr || !(command->modes & IMMEDIATE_MODE)) {
+        standardOutput() << "SYNTAX ERROR\n";
+        return;
+    }
+    if (command->run != nullptr) {
+        if (!command->run(tokens, program, state)) {
+            standardOutput() << "SYNTAX ERROR\n";
+        }
+        return;
+    }
+    Statement stmt;
+    if (!command->parse(tokens, stmt)) {
+        standardOutput() << "SYNTAX ERROR\n";
+        return;
+    }
+    executeStatement(stmt, state, program);
+}
+
+/*
+ * Function: parseStoredLine
+ * Usage: parseStoredLine(line, stmt);
+ * -----------------------------------
+ * Parses a numbered line that was stored without being parsed.  The
+ * line has already passed the check function of its command, so the
+ * command exists and its parse function accepts the line.  Like a line
+ * entered by the user, the statement is looked up in the parse cache
+ * first, so lines that repeat a statement share its expression trees.
+ */
+
+void parseStoredLine(std::string_view line, Statement &stmt) {
+    std::string_view number, body;
+    bool cacheable = splitLineNumber(line, number, body);
+    if (cacheable) {
+        if (const Statement *cached = parseCache.lookup(body)) {
+            stmt = *cached;
+            return;
+        }
+    }
+    TokenArray tokens;
+    tokens.setInput(line);
+    tokens.nextToken();
+    const Command *command = findCommand(tokens.nextToken());
+    command->parse(tokens, stmt);
+    if (cacheable) parseCache.insert(body, stmt);
+}
+
+/*
+ * Constants: LOAD_BATCH_LINES, LOAD_LINES_PER_THREAD
+ * --------------------------------------------------
+ * loadProgram parses at most LOAD_BATCH_LINES numbered lines before
+ * storing them, which bounds the number of parsed statements waiting
+ * to be stored, and it starts one thread for every
+ * LOAD_LINES_PER_THREAD lines of a batch, up to the number of
+ * processors.
+ */
+
+const std::size_t LOAD_BATCH_LINES = 65536;
+
+const std::size_t LOAD_LINES_PER_THREAD = 1024;
+
+/*
+ * Function: parseLoadedLines
+ * Usage: parseLoadedLines(batch, parsed, first, last);
+ * ----------------------------------------------------
+ * Parses the numbered lines of batch with indices from first up to
+ * but not including last.  An error raised by a line is kept in its
+ * NumberedLine, to be printed when the line is stored.  Running out of
+ * memory is kept as OUT OF MEMORY, as chargeMemory reports it, since
+ * an exception must not escape a worker thread.
+ */
+
+static void parseLoadedLines(const std::vector<std::string_view> &batch, std::vector<NumberedLine> &parsed,
+                             std::size_t first, std::size_t last) {
+    TokenArray tokens;
+    for (std::size_t i = first; i < last; i++) {
+        NumberedLine &line = parsed[i];
+        line.text = batch[i];
+        try {
+            tokens.setInput(batch[i]);
+            int lineNumber = stringToInteger(tokens.nextToken());
+            parseNumberedLine(tokens, lineNumber, line);
+        } catch (ErrorException &ex) {
+            line.action = NumberedLine::FAIL;
+            line.message = ex.getMessage();
+        } catch (std::bad_alloc &) {
+            line.action = NumberedLine::FAIL;
+            line.message = "OUT OF MEMORY";
+        }
+    }
+}
+
+/*
+ * Function: storeLoadedLines
+ * Usage: storeLoadedLines(batch, program);
+ * ----------------------------------------
+ * Parses the numbered lines of batch, dividing them among several
+ * threads, and then stores them, which gives the same program and the
+ * same messages as entering the lines one after another.  The error
+ * messages are printed in the order of the lines.  The other lines are
+ * sorted by line number, keeping only the last line with each number,
+ * and merged into the program in a single pass.
+ */
+
+static void storeLoadedLines(std::vector<std::string_view> &batch, Program &program) {
+    std::vector<NumberedLine> parsed(batch.size());
+    std::size_t threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    threads = std::min(threads, (batch.size() + LOAD_LINES_PER_THREAD - 1) / LOAD_LINES_PER_THREAD);
+    if (threads <= 1) {
+        parseLoadedLines(batch, parsed, 0, batch.size());
+    } else {
+        std::vector<std::thread> workers;
+        std::size_t chunk = (batch.size() + threads - 1) / threads;
+        for (std::size_t first = chunk; first < batch.size(); first += chunk) {
+            std::size_t last = std::min(first + chunk, batch.size());
+            workers.emplace_back(parseLoadedLines, std::cref(batch), std::ref(parsed), first, last);
+        }
+        parseLoadedLines(batch, parsed, 0, std::min(chunk, batch.size()));
+        for (std::thread &worker: workers) {
+            worker.join();
+        }
+    }
+    std::vector<std::size_t> order;
+    for (std::size_t i = 0; i < parsed.size(); i++) {
+        if (parsed[i].action == NumberedLine::REJECT || parsed[i].action == NumberedLine::FAIL) {
+            storeNumberedLine(parsed[i], program);
+        } else {
+            order.push_back(i);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&parsed](std::size_t a, std::size_t b) {
+        return parsed[a].lineNumber < parsed[b].lineNumber;
+    });
+    std::vector<Program::LineEdit> edits;
+    for (std::size_t k = 0; k < order.size(); k++) {
+        NumberedLine &line = parsed[order[k]];
+        if (k + 1 < order.size() && parsed[order[k + 1]].lineNumber == line.lineNumber) continue;
+        edits.push_back({line.lineNumber, line.text, line.action == NumberedLine::REMOVE,
+                         line.action == NumberedLine::ADD, std::move(line.stmt)});
+    }
+    parsed.clear();
+    try {
+        program.mergeLines(edits);
+    } catch (ErrorException &ex) {
+        standardOutput() << ex.getMessage() << '\n';
+        standardOutput().flush();
+    }
+    batch.clear();
+}
+
+/*
+ * Function: loadProgram
+ * Usage: loadProgram(text, program, state);
+ * -----------------------------------------
+ * Processes every line of text as if it had been entered by the user,
+ * except that blank lines are skipped instead of ending the session.
+ * Runs of numbered lines are parsed in parallel by storeLoadedLines;
+ * any other line is a command and is executed in its place in the
+ * sequence, after all the lines before it have been stored.
+ */
+
+void loadProgram(std::string_view text, Program &program, EvalState &state) {
+    std::vector<std::string_view> batch;
+    std::size_t start = 0;
+    while (start < text.length()) {
+        std::size_t end = text.find('\n', start);
+        if (end == std::string_view::npos) end = text.length();
+        std::string_view line = text.substr(start, end - start);
+        start = end + 1;
+        if (line.empty()) continue;
+        std::size_t first = 0;
+        while (first < line.length() && isspace((unsigned char) line[first])) {
+            first++;
+        }
+        if (first < line.length() && isdigit((unsigned char) line[first])) {
+            batch.push_back(line);
+            if (batch.size() == LOAD_BATCH_LINES) storeLoadedLines(batch, program);
+            continue;
+        }
+        if (!batch.empty()) storeLoadedLines(batch, program);
+        executeLine(std::string(line), program, state);
+    }
+    if (!batch.empty()) storeLoadedLines(batch, program);
+}
@@ -0,0 +1,155 @@
+/*
+ * File: inputBuffer.cpp
+ * ---------------------
+ * This file implements the inputBuffer.h interface.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <unistd.h>
+#include "inputBuffer.hpp"
+#include "spscRing.hpp"
+
+/*
+ * Constant: STANDARD_INPUT_CAPACITY
+ * ---------------------------------
+ * The size of the blocks read from the standard input.
+ */
+
+static const std::size_t STANDARD_INPUT_CAPACITY = 1 << 16;
+
+/*
+ * Type: Prefetcher
+ * ----------------
+ * The state shared with the prefetch thread, which passes the input
+ * through the ring in blocks of whole lines.  Passing blocks rather
+ * than single lines means the two threads only meet once per read,
+ * which matters most when they share a processor.
+ */
+
+struct InputBuffer::Prefetcher {
+    int fd;
+    std::size_t blockSize;
+    SpscRing<std::string> blocks;
+};
+
+InputBuffer::InputBuffer(int fd, std::size_t capacity) : fd(fd), buffer(capacity, '\0') {}
+
+bool InputBuffer::readLine(std::string_view &line) {
+    if (prefetcher != nullptr) return readPrefetchedLine(line);
+    while (true) {
+        const char *data = buffer.data();
+        const char *newline = (const char *) std::memchr(data + start, '\n', end - start);
+        if (newline != nullptr) {
+            line = std::string_view(data + start, newline - (data + start));
+            start = newline - data + 1;
+            return true;
+        }
+        if (!fill()) break;
+    }
+    line = std::string_view(buffer.data() + start, end - start);
+    start = end;
+    return !line.empty();
+}
+
+bool InputBuffer::isLineReady() const {
+    if (prefetcher != nullptr) return blockPos < block.size() || !prefetcher->blocks.isEmpty();
+    return atEnd || std::memchr(buffer.data() + start, '\n', end - start) != nullptr;
+}
+
+/*
+ * Implementation notes: startPrefetch
+ * -----------------------------------
+ * Each block ends with a newline, except for the last one if the input
+ * does not; the part of a read after its last newline is carried over
+ * to the next block.  The thread shares ownership of the prefetcher
+ * and is detached, since it may be blocked in ::read when the
+ * interpreter exits; the state it uses then stays alive until the
+ * process ends.
+ */
+
+void InputBuffer::startPrefetch(std::size_t blocks) {
+    prefetcher.reset(new Prefetcher{fd, buffer.size(), SpscRing<std::string>(blocks)});
+    std::thread([](std::shared_ptr<Prefetcher> shared) {
+        std::string block, carry;
+        while (true) {
+            block.swap(carry);
+            std::size_t old = block.size();
+            block.resize(old + shared->blockSize);
+            ssize_t count;
+            do {
+                count = ::read(shared->fd, &block[old], shared->blockSize);
+            } while (count < 0 && errno == EINTR);
+            if (count <= 0) {
+                block.resize(old);
+                break;
+            }
+            block.resize(old + count);
+            std::size_t last = block.rfind('\n');
+            if (last == std::string::npos) {
+                carry.swap(block);
+                continue;
+            }
+            carry.assign(block, last + 1, std::string::npos);
+            block.resize(last + 1);
+            shared->blocks.push(block);
+        }
+        if (!block.empty()) shared->blocks.push(block);
+        shared->blocks.close();
+    }, prefetcher).detach();
+}
+
+bool InputBuffer::readPrefetchedLine(std::string_view &line) {
+    if (blockPos == block.size()) {
+        blockPos = 0;
+        if (!prefetcher->blocks.pop(block)) {
+            block.clear();
+            line = std::string_view();
+            return false;
+        }
+    }
+    std::size_t newline = block.find('\n', blockPos);
+    std::size_t next = newline;
+    if (newline == std::string::npos) {
+        newline = next = block.size();
+    } else {
+        next++;
+    }
+    line = std::string_view(block.data() + blockPos, newline - blockPos);
+    blockPos = next;
+    return true;
+}
+
+/*
+ * Implementation notes: fill
+ * --------------------------
+ * The unfinished line is moved to the front of the buffer before
+ * reading, and the buffer is doubled if the line already fills it.
+ * An error other than EINTR is treated as the end of the input.
+ */
+
+bool InputBuffer::fill() {
+    if (atEnd) return false;
+    if (start > 0) {
+        std::memmove(&buffer[0], buffer.data() + start, end - start);
+        end -= start;
+        start = 0;
+    }
+    if (end == buffer.size()) buffer.resize(2 * buffer.size());
+    while (true) {
+        ssize_t count = ::read(fd, &buffer[end], buffer.size() - end);
+        if (count > 0) {
+            end += count;
+            return true;
+        }
+        if (count < 0 && errno == EINTR) continue;
+        atEnd = true;
+        return false;
+    }
+}
+
+InputBuffer &standardInput() {
+    static InputBuffer in(STDIN_FILENO, STANDARD_INPUT_CAPACITY);
+    return in;
+}
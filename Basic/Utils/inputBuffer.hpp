@@ -0,0 +1,106 @@
+#ifndef CODE_INPUTBUFFER_HPP
+#define CODE_INPUTBUFFER_HPP
+
+/*
+ * File: inputBuffer.h
+ * -------------------
+ * This file exports the InputBuffer class, the counterpart of
+ * OutputBuffer for input.  It reads a file descriptor with ::read in
+ * large blocks and hands out the lines as views into its buffer, so a
+ * line is only copied if the caller needs to keep it.
+ */
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/*
+ * Class: InputBuffer
+ * ------------------
+ * Splits the data read from a file descriptor into lines.  A read
+ * returns as soon as some data is available, so the buffer never
+ * waits for more input than the line it is asked for.
+ */
+
+class InputBuffer {
+
+public:
+
+/*
+ * Constructor: InputBuffer
+ * Usage: InputBuffer in(fd, capacity);
+ * ------------------------------------
+ * Creates a buffer for the file descriptor that reads up to capacity
+ * bytes at a time.  The buffer grows if a line is longer.
+ */
+
+    InputBuffer(int fd, std::size_t capacity);
+
+/*
+ * Method: readLine
+ * Usage: if (in.readLine(line)) ...
+ * ---------------------------------
+ * Sets line to the next line of input, without its newline, and
+ * returns true.  The last line need not end with a newline.  At the
+ * end of the input, readLine returns false and sets line to the empty
+ * string.  The view stays valid until the next call.
+ */
+
+    bool readLine(std::string_view &line);
+
+/*
+ * Method: isLineReady
+ * Usage: if (!in.isLineReady()) out.sync();
+ * -----------------------------------------
+ * Returns true if the next call to readLine will return without
+ * waiting for more input, because a complete line is already buffered
+ * or the end of the input has been reached.
+ */
+
+    bool isLineReady() const;
+
+/*
+ * Method: startPrefetch
+ * Usage: in.startPrefetch(blocks);
+ * --------------------------------
+ * Starts a thread that reads the input ahead, so that waiting for
+ * input overlaps with the work done between calls to readLine, which
+ * from then on takes its lines from that thread.  The thread keeps up
+ * to the given number of blocks ready, each holding the complete lines
+ * returned by one read.  It must be called before the first readLine,
+ * and it ends with the input or with the process.
+ */
+
+    void startPrefetch(std::size_t blocks);
+
+private:
+
+    struct Prefetcher;
+
+    bool fill();
+
+    bool readPrefetchedLine(std::string_view &line);
+
+    int fd;
+    std::string buffer;
+    std::size_t start = 0;      /* First byte not yet returned */
+    std::size_t end = 0;        /* End of the data read so far */
+    bool atEnd = false;
+    std::shared_ptr<Prefetcher> prefetcher;
+    std::string block;          /* The block last taken from prefetcher */
+    std::size_t blockPos = 0;   /* The start of the next line in block */
+
+};
+
+/*
+ * Function: standardInput
+ * Usage: standardInput().readLine(line);
+ * --------------------------------------
+ * Returns the buffer for the standard input, from which both the
+ * commands and the answers to INPUT are read.
+ */
+
+InputBuffer &standardInput();
+
+#endif //CODE_INPUTBUFFER_HPP
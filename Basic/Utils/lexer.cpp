@@ -0,0 +1,277 @@
+/*
+ * File: lexer.cpp
+ * ---------------
+ * This file implements the lexer.h interface.  The line is classified
+ * in blocks of 32 characters; for each block three bit masks record
+ * which characters are whitespace, digits and word characters (letters
+ * or digits).  The scanner below then finds the end of every run of
+ * spaces, digits or word characters by counting the trailing bits of
+ * the masks instead of testing the characters one at a time.
+ *
+ * The classification follows the C locale, as the original token
+ * scanner did: whitespace is the space and the characters from '\t'
+ * to '\r', and a character outside ASCII is never a space, digit or
+ * letter.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include "lexer.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LEXER_X86
+#include <immintrin.h>
+#endif
+
+/*
+ * Type: CharClasses
+ * -----------------
+ * The class masks of one block.  Bit i describes character i of the
+ * block; the bits of characters past the end of the line are zero.
+ */
+
+struct CharClasses {
+    uint32_t space;
+    uint32_t digit;
+    uint32_t word;
+};
+
+typedef CharClasses (*ClassifyFn)(const char *block, std::size_t count);
+
+static CharClasses classifyScalar(const char *block, std::size_t count) {
+    CharClasses classes = {0, 0, 0};
+    for (std::size_t i = 0; i < count; i++) {
+        unsigned char ch = block[i];
+        uint32_t bit = uint32_t(1) << i;
+        if (ch == ' ' || (ch >= '\t' && ch <= '\r')) classes.space |= bit;
+        if (ch >= '0' && ch <= '9') {
+            classes.digit |= bit;
+            classes.word |= bit;
+        } else if ((ch | 0x20) >= 'a' && (ch | 0x20) <= 'z') {
+            classes.word |= bit;
+        }
+    }
+    return classes;
+}
+
+#ifdef LEXER_X86
+
+/*
+ * Implementation notes: classifySSE2, classifyAVX2
+ * ------------------------------------------------
+ * The range tests use signed byte comparisons, under which every
+ * character outside ASCII is negative and therefore below each of
+ * the ranges.  Letters are tested in one range by setting the 0x20
+ * bit, which maps 'A'-'Z' onto 'a'-'z'.  A block that runs past the
+ * end of the line is first copied into a buffer padded with zeros,
+ * which belong to none of the classes.
+ */
+
+static inline __m128i inRange16(__m128i chars, char low, char high) {
+    return _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8(low - 1)),
+                         _mm_cmplt_epi8(chars, _mm_set1_epi8(high + 1)));
+}
+
+static uint32_t maskSSE2(__m128i chars, int which) {
+    __m128i digit = inRange16(chars, '0', '9');
+    __m128i result;
+    if (which == 0) {
+        result = _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8(' ')),
+                              inRange16(chars, '\t', '\r'));
+    } else if (which == 1) {
+        result = digit;
+    } else {
+        __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+        result = _mm_or_si128(digit, inRange16(lower, 'a', 'z'));
+    }
+    return uint32_t(_mm_movemask_epi8(result)) & 0xFFFF;
+}
+
+static CharClasses classifySSE2(const char *block, std::size_t count) {
+    alignas(32) char padded[32];
+    if (count < 32) {
+        std::memset(padded, 0, sizeof padded);
+        std::memcpy(padded, block, count);
+        block = padded;
+    }
+    __m128i low = _mm_loadu_si128((const __m128i *) block);
+    __m128i high = _mm_loadu_si128((const __m128i *) (block + 16));
+    CharClasses classes;
+    classes.space = maskSSE2(low, 0) | maskSSE2(high, 0) << 16;
+    classes.digit = maskSSE2(low, 1) | maskSSE2(high, 1) << 16;
+    classes.word = maskSSE2(low, 2) | maskSSE2(high, 2) << 16;
+    return classes;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i inRange32(__m256i chars, char low, char high) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8(low - 1)),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(high + 1), chars));
+}
+
+__attribute__((target("avx2")))
+static CharClasses classifyAVX2(const char *block, std::size_t count) {
+    alignas(32) char padded[32];
+    if (count < 32) {
+        std::memset(padded, 0, sizeof padded);
+        std::memcpy(padded, block, count);
+        block = padded;
+    }
+    __m256i chars = _mm256_loadu_si256((const __m256i *) block);
+    __m256i digit = inRange32(chars, '0', '9');
+    __m256i space = _mm256_or_si256(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8(' ')),
+                                    inRange32(chars, '\t', '\r'));
+    __m256i lower = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+    __m256i word = _mm256_or_si256(digit, inRange32(lower, 'a', 'z'));
+    CharClasses classes;
+    classes.space = uint32_t(_mm256_movemask_epi8(space));
+    classes.digit = uint32_t(_mm256_movemask_epi8(digit));
+    classes.word = uint32_t(_mm256_movemask_epi8(word));
+    return classes;
+}
+
+#endif
+
+/*
+ * Implementation notes: selectClassifier
+ * --------------------------------------
+ * The classifier is chosen once, on the first call, from the features
+ * of the processor the interpreter runs on.
+ */
+
+static ClassifyFn selectClassifier() {
+#ifdef LEXER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return classifyAVX2;
+    if (__builtin_cpu_supports("sse2")) return classifySSE2;
+#endif
+    return classifyScalar;
+}
+
+/*
+ * Class: LineClasses
+ * ------------------
+ * Gives access to the class masks of a line.  The masks of the block
+ * containing the current position are computed on demand and kept
+ * until the scanner moves to another block.
+ */
+
+class LineClasses {
+
+public:
+
+    LineClasses(std::string_view line, ClassifyFn classify) : line(line), classify(classify) {}
+
+    bool is(uint32_t CharClasses::*mask, std::size_t pos) {
+        return pos < line.length() && (load(pos).*mask >> (pos % 32) & 1);
+    }
+
+/*
+ * Method: skip
+ * ------------
+ * Returns the first position at or after pos that does not belong to
+ * the class, or the length of the line if there is none.
+ */
+
+    std::size_t skip(uint32_t CharClasses::*mask, std::size_t pos) {
+        while (pos < line.length()) {
+            uint32_t outside = ~(load(pos).*mask) >> (pos % 32);
+            if (outside != 0) return pos + __builtin_ctz(outside);
+            pos = pos - pos % 32 + 32;
+        }
+        return line.length();
+    }
+
+private:
+
+    const CharClasses &load(std::size_t pos) {
+        std::size_t start = pos - pos % 32;
+        if (start != blockStart) {
+            blockStart = start;
+            std::size_t count = line.length() - start;
+            classes = classify(line.data() + start, count < 32 ? count : 32);
+        }
+        return classes;
+    }
+
+    std::string_view line;
+    ClassifyFn classify;
+    std::size_t blockStart = std::size_t(-1);
+    CharClasses classes = {};
+
+};
+
+/*
+ * Implementation notes: lexLine
+ * -----------------------------
+ * The number scanner mirrors the finite-state machine of the original
+ * token scanner.  When an exponent is incomplete, the token keeps the
+ * 'E' and the sign but the scan resumes at the 'E'; when the line ends
+ * inside the number, the token is whatever was accepted and nothing
+ * further is read.
+ */
+
+bool lexLine(std::string_view line, std::vector<Lexeme> &lexemes) {
+    static const ClassifyFn classify = selectClassifier();
+    LineClasses classes(line, classify);
+    std::size_t n = line.length();
+    lexemes.clear();
+    std::size_t pos = 0;
+    while (true) {
+        pos = classes.skip(&CharClasses::space, pos);
+        if (pos == n) return false;
+        std::size_t start = pos;
+        if (classes.is(&CharClasses::digit, pos)) {
+            pos = classes.skip(&CharClasses::digit, pos + 1);
+            if (pos < n && line[pos] == '.') {
+                pos = classes.skip(&CharClasses::digit, pos + 1);
+            }
+            std::size_t end = pos;
+            std::size_t resume = pos;
+            if (pos < n && (line[pos] == 'E' || line[pos] == 'e')) {
+                std::size_t next = pos + 1;
+                if (next < n && (line[next] == '+' || line[next] == '-')) next++;
+                if (classes.is(&CharClasses::digit, next)) {
+                    end = resume = classes.skip(&CharClasses::digit, next);
+                } else {
+                    end = next;
+                    resume = next == n ? n : pos;
+                }
+            }
+            lexemes.push_back({LEX_NUMBER, unsigned(start), unsigned(end - start), unsigned(resume)});
+            if (end == n) return true;
+            pos = resume;
+        } else if (classes.is(&CharClasses::word, pos)) {
+            pos = classes.skip(&CharClasses::word, pos + 1);
+            lexemes.push_back({LEX_WORD, unsigned(start), unsigned(pos - start), unsigned(pos)});
+            if (pos == n) return true;
+        } else {
+            pos++;
+            lexemes.push_back({LEX_OPERATOR, unsigned(start), 1, unsigned(pos)});
+        }
+    }
+}
+
+void TokenArray::setInput(std::string_view line) {
+    this->line = line;
+    lexLine(line, lexemes);
+    index = 0;
+}
+
+bool TokenArray::readString(std::string_view &text) {
+    if (peekToken() != "\"") return false;
+    std::size_t open = lexemes[index].offset;
+    std::size_t close = line.find('"', open + 1);
+    if (close == std::string_view::npos) return false;
+    text = line.substr(open + 1, close - open - 1);
+    while (index < lexemes.size() && lexemes[index].offset <= close) index++;
+    return true;
+}
+
+LexemeKind TokenArray::getTokenKind(std::string_view token) const {
+    if (token.empty()) return LEX_END;
+    unsigned char ch = token[0];
+    if (ch >= '0' && ch <= '9') return LEX_NUMBER;
+    if ((ch | 0x20) >= 'a' && (ch | 0x20) <= 'z') return LEX_WORD;
+    return LEX_OPERATOR;
+}
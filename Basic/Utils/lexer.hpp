@@ -0,0 +1,159 @@
+#ifndef CODE_LEXER_HPP
+#define CODE_LEXER_HPP
+
+/*
+ * File: lexer.h
+ * -------------
+ * This file exports a lexer that splits a whole line into tokens in
+ * one pass.  It produces exactly the tokens that the Stanford library
+ * TokenScanner set up with ignoreWhitespace and scanNumbers (and
+ * nothing else) would return, but it classifies the characters of the
+ * line 32 at a time with SSE2 or AVX2 instructions where the processor
+ * has them.  The TokenArray class below gives the parser access to
+ * the tokens of a line.
+ */
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+/*
+ * Type: LexemeKind
+ * ----------------
+ * The kind of a lexeme, which is decided by its first character.
+ * LEX_END is not the kind of any lexeme; it marks the end of a line.
+ */
+
+enum LexemeKind {
+    LEX_WORD, LEX_NUMBER, LEX_OPERATOR, LEX_END
+};
+
+/*
+ * Type: Lexeme
+ * ------------
+ * One token of a line.  The text of the token is the length bytes
+ * starting at offset.  The resume field is the position at which the
+ * scan for the next token starts, which is normally the end of the
+ * token; it lies before the end if the token ends in an incomplete
+ * exponent such as "1e" or "1e+", which the scanner gives back except
+ * for the first character of the exponent.
+ */
+
+struct Lexeme {
+    LexemeKind kind;
+    unsigned offset;
+    unsigned length;
+    unsigned resume;
+};
+
+/*
+ * Function: lexLine
+ * Usage: bool hitEnd = lexLine(line, lexemes);
+ * --------------------------------------------
+ * Replaces the contents of lexemes with the tokens of line and
+ * returns true if scanning the last token ran into the end of the
+ * line.  Once the scan has run into the end of the line, nothing more
+ * is read from it, even if the last token gave characters back.
+ */
+
+bool lexLine(std::string_view line, std::vector<Lexeme> &lexemes);
+
+/*
+ * Class: TokenArray
+ * -----------------
+ * The tokens of one line, as produced by lexLine, together with a
+ * cursor.  A TokenArray can look at the next token without consuming
+ * it, so a parser never has to push a token back, and neither looking
+ * nor consuming allocates.  The tokens are views into the line, which
+ * must outlive the TokenArray.
+ */
+
+class TokenArray {
+
+public:
+
+/*
+ * Method: setInput
+ * Usage: tokens.setInput(line);
+ * -----------------------------
+ * Splits the line into tokens and moves the cursor to the first one.
+ */
+
+    void setInput(std::string_view line);
+
+/*
+ * Method: hasMoreTokens
+ * Usage: if (tokens.hasMoreTokens()) ...
+ * --------------------------------------
+ * Returns true if there are tokens left after the cursor.
+ */
+
+    bool hasMoreTokens() const {
+        return index < lexemes.size();
+    }
+
+/*
+ * Methods: nextToken, peekToken
+ * Usage: std::string_view token = tokens.nextToken();
+ *        std::string_view token = tokens.peekToken();
+ * ---------------------------------------------------
+ * Return the token at the cursor, or the empty string at the end of
+ * the line.  nextToken also moves the cursor past the token.
+ */
+
+    std::string_view nextToken() {
+        if (index == lexemes.size()) return std::string_view();
+        const Lexeme &lexeme = lexemes[index++];
+        return line.substr(lexeme.offset, lexeme.length);
+    }
+
+    std::string_view peekToken() const {
+        if (index == lexemes.size()) return std::string_view();
+        return line.substr(lexemes[index].offset, lexemes[index].length);
+    }
+
+/*
+ * Method: peekKind
+ * Usage: LexemeKind kind = tokens.peekKind();
+ * -------------------------------------------
+ * Returns the kind of the token at the cursor, or LEX_END at the end
+ * of the line.
+ */
+
+    LexemeKind peekKind() const {
+        return index == lexemes.size() ? LEX_END : lexemes[index].kind;
+    }
+
+/*
+ * Method: getTokenKind
+ * Usage: LexemeKind kind = tokens.getTokenKind(token);
+ * ----------------------------------------------------
+ * Returns the kind of a token returned by nextToken, which is decided
+ * by its first character.
+ */
+
+    LexemeKind getTokenKind(std::string_view token) const;
+
+/*
+ * Method: readString
+ * Usage: if (tokens.readString(text)) ...
+ * ---------------------------------------
+ * Reads a string in double quotes starting at the cursor.  The lexer
+ * knows nothing of strings, so the text is taken from the line itself
+ * and may contain any character but a double quote; the cursor moves
+ * to the first token after the closing quote.  Returns false, without
+ * moving the cursor, if the token at the cursor is not a double quote
+ * or the string is not closed.
+ */
+
+    bool readString(std::string_view &text);
+
+private:
+
+    std::string_view line;
+    std::vector<Lexeme> lexemes;
+    std::size_t index = 0;
+
+};
+
+#endif //CODE_LEXER_HPP
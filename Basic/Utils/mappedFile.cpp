@@ -0,0 +1,63 @@
+/*
+ * File: mappedFile.cpp
+ * --------------------
+ * This file implements the mappedFile.h interface.
+ */
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mappedFile.hpp"
+
+/*
+ * Implementation notes: MappedFile
+ * --------------------------------
+ * Only regular files are mapped; an empty file needs no mapping, and
+ * anything else is read to its end with ::read.  The kernel is told
+ * that the mapping will be read once from front to back, so it reads
+ * ahead aggressively.  The descriptor is not needed once the mapping
+ * exists.
+ */
+
+MappedFile::MappedFile(const std::string &path) {
+    int fd;
+    do {
+        fd = ::open(path.c_str(), O_RDONLY);
+    } while (fd < 0 && errno == EINTR);
+    if (fd < 0) return;
+    open = true;
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+        if (info.st_size == 0) {
+            ::close(fd);
+            return;
+        }
+        void *address = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            ::madvise(address, info.st_size, MADV_SEQUENTIAL);
+            ::close(fd);
+            mapping = address;
+            mappedSize = info.st_size;
+            text = std::string_view((const char *) address, mappedSize);
+            return;
+        }
+    }
+    char block[1 << 16];
+    while (true) {
+        ssize_t count = ::read(fd, block, sizeof block);
+        if (count > 0) {
+            copy.append(block, count);
+            continue;
+        }
+        if (count < 0 && errno == EINTR) continue;
+        break;
+    }
+    ::close(fd);
+    text = copy;
+}
+
+MappedFile::~MappedFile() {
+    if (mapping != nullptr) ::munmap(mapping, mappedSize);
+}
@@ -0,0 +1,84 @@
+#ifndef CODE_MAPPEDFILE_HPP
+#define CODE_MAPPEDFILE_HPP
+
+/*
+ * File: mappedFile.h
+ * ------------------
+ * This file exports the MappedFile class, which gives read-only access
+ * to the contents of a file by mapping it into memory.  The text is
+ * paged in as it is used, so nothing is read or copied up front and
+ * the lines of the file can be handed out as views into the mapping.
+ */
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/*
+ * Class: MappedFile
+ * -----------------
+ * The contents of one file, which stay available for as long as the
+ * MappedFile exists.  A file that cannot be mapped, such as a pipe,
+ * is read into memory instead.
+ */
+
+class MappedFile {
+
+public:
+
+/*
+ * Constructor: MappedFile
+ * Usage: MappedFile file(path);
+ * -----------------------------
+ * Opens and maps the named file.  If the file cannot be opened, isOpen
+ * returns false and the text is empty.
+ */
+
+    explicit MappedFile(const std::string &path);
+
+/*
+ * Destructor: ~MappedFile
+ * Usage: usually implicit
+ * -----------------------
+ * Removes the mapping, which invalidates every view into the text.
+ */
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+/*
+ * Method: isOpen
+ * Usage: if (file.isOpen()) ...
+ * -----------------------------
+ * Returns true if the file was opened.
+ */
+
+    bool isOpen() const {
+        return open;
+    }
+
+/*
+ * Method: getText
+ * Usage: std::string_view text = file.getText();
+ * ----------------------------------------------
+ * Returns the contents of the file.
+ */
+
+    std::string_view getText() const {
+        return text;
+    }
+
+private:
+
+    bool open = false;
+    void *mapping = nullptr;
+    std::size_t mappedSize = 0;
+    std::string copy;           /* The contents if they are not mapped */
+    std::string_view text;
+
+};
+
+#endif //CODE_MAPPEDFILE_HPP
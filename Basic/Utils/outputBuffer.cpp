@@ -0,0 +1,224 @@
+/*
+ * File: outputBuffer.cpp
+ * ----------------------
+ * This file implements the outputBuffer.h interface.
+ */
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "outputBuffer.hpp"
+#include "spscRing.hpp"
+#include "strlib.hpp"
+
+/*
+ * Constant: STANDARD_OUTPUT_CAPACITY
+ * ----------------------------------
+ * The size of the buffer for the standard output.
+ */
+
+static const std::size_t STANDARD_OUTPUT_CAPACITY = 1 << 16;
+
+/*
+ * Constant: WRITEV_CHUNKS
+ * -----------------------
+ * The largest number of waiting buffers the writer thread passes to
+ * one call of ::writev.
+ */
+
+static const int WRITEV_CHUNKS = 16;
+
+/*
+ * Type: Writer
+ * ------------
+ * The state of the writer thread in asynchronous mode.  The chunks
+ * ring carries copies of the buffer; written counts the chunks that
+ * the thread has finished with, which sync compares with submitted.
+ */
+
+struct OutputBuffer::Writer {
+    explicit Writer(std::size_t chunks) : chunks(chunks) {}
+
+    SpscRing<std::string> chunks;
+    std::string chunk;                  /* Recycled storage for emit */
+    std::size_t submitted = 0;
+    std::size_t written = 0;
+    std::mutex mutex;
+    std::condition_variable progress;
+    std::thread thread;
+};
+
+static void writeAll(int fd, const char *text, std::size_t length);
+static void writeAll(int fd, struct iovec *iov, int count);
+
+OutputBuffer::OutputBuffer(int fd, std::size_t capacity)
+        : fd(fd), buffer(new char[capacity]), capacity(capacity) {}
+
+OutputBuffer::~OutputBuffer() {
+    flush();
+    if (writer != nullptr) {
+        writer->chunks.close();
+        writer->thread.join();
+    }
+}
+
+/*
+ * Implementation notes: startWriter
+ * ---------------------------------
+ * The thread waits for one chunk and then takes whatever else is
+ * already waiting, so that a burst of output is written with a single
+ * system call.
+ */
+
+void OutputBuffer::startWriter(std::size_t chunks) {
+    flush();
+    writer.reset(new Writer(chunks));
+    Writer *shared = writer.get();
+    int target = fd;
+    shared->thread = std::thread([shared, target] {
+        std::string batch[WRITEV_CHUNKS];
+        while (shared->chunks.pop(batch[0])) {
+            int count = 1;
+            while (count < WRITEV_CHUNKS && shared->chunks.tryPop(batch[count])) {
+                count++;
+            }
+            struct iovec iov[WRITEV_CHUNKS];
+            for (int i = 0; i < count; i++) {
+                iov[i].iov_base = &batch[i][0];
+                iov[i].iov_len = batch[i].size();
+            }
+            writeAll(target, iov, count);
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            shared->written += count;
+            shared->progress.notify_all();
+        }
+    });
+}
+
+void OutputBuffer::setLineBuffered(bool flag) {
+    lineBuffered = flag;
+}
+
+void OutputBuffer::flush() {
+    if (used > 0) emit(buffer.get(), used);
+    used = 0;
+}
+
+void OutputBuffer::sync() {
+    flush();
+    if (writer != nullptr) {
+        std::unique_lock<std::mutex> lock(writer->mutex);
+        writer->progress.wait(lock, [this] { return writer->written == writer->submitted; });
+    }
+}
+
+OutputBuffer &OutputBuffer::operator<<(std::string_view text) {
+    append(text.data(), text.length());
+    return *this;
+}
+
+OutputBuffer &OutputBuffer::operator<<(const char *text) {
+    append(text, std::strlen(text));
+    return *this;
+}
+
+OutputBuffer &OutputBuffer::operator<<(char ch) {
+    append(&ch, 1);
+    return *this;
+}
+
+OutputBuffer &OutputBuffer::operator<<(int value) {
+    return *this << (long long) value;
+}
+
+/*
+ * Implementation notes: operator<< for integers
+ * ---------------------------------------------
+ * The digits are formatted straight into the buffer, which is flushed
+ * first if it might not have room for them.
+ */
+
+OutputBuffer &OutputBuffer::operator<<(long long value) {
+    if (capacity - used < MAX_INTEGER_CHARS) flush();
+    used = formatInteger(buffer.get() + used, value) - buffer.get();
+    return *this;
+}
+
+/*
+ * Implementation notes: append
+ * ----------------------------
+ * Text too long for the buffer is written directly instead of being
+ * copied in pieces.
+ */
+
+void OutputBuffer::append(const char *text, std::size_t length) {
+    if (length > capacity - used) {
+        flush();
+        if (length > capacity) {
+            emit(text, length);
+            return;
+        }
+    }
+    std::memcpy(buffer.get() + used, text, length);
+    used += length;
+    if (lineBuffered && std::memchr(text, '\n', length) != nullptr) flush();
+}
+
+/*
+ * Implementation notes: emit
+ * --------------------------
+ * In asynchronous mode the text is copied into a chunk and queued,
+ * which keeps it in order with everything queued before it.
+ */
+
+void OutputBuffer::emit(const char *text, std::size_t length) {
+    if (writer == nullptr) {
+        writeAll(fd, text, length);
+        return;
+    }
+    writer->chunk.assign(text, length);
+    writer->chunks.push(writer->chunk);
+    writer->submitted++;
+}
+
+/*
+ * Implementation notes: writeAll
+ * ------------------------------
+ * ::write and ::writev may write less than they were asked to, and
+ * they fail with EINTR if a signal arrives first; in both cases they
+ * are simply called again for the rest.  Any other failure drops the
+ * text.
+ */
+
+static void writeAll(int fd, const char *text, std::size_t length) {
+    struct iovec iov = {(void *) text, length};
+    writeAll(fd, &iov, 1);
+}
+
+static void writeAll(int fd, struct iovec *iov, int count) {
+    while (count > 0) {
+        ssize_t done = ::writev(fd, iov, count);
+        if (done < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        while (count > 0 && std::size_t(done) >= iov->iov_len) {
+            done -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char *) iov->iov_base + done;
+            iov->iov_len -= done;
+        }
+    }
+}
+
+OutputBuffer &standardOutput() {
+    static OutputBuffer out(STDOUT_FILENO, STANDARD_OUTPUT_CAPACITY);
+    return out;
+}
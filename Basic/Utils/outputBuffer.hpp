@@ -0,0 +1,145 @@
+#ifndef CODE_OUTPUTBUFFER_HPP
+#define CODE_OUTPUTBUFFER_HPP
+
+/*
+ * File: outputBuffer.h
+ * --------------------
+ * This file exports the OutputBuffer class, a minimal replacement for
+ * std::cout that collects the output of the interpreter in one large
+ * buffer and passes it to the operating system with ::write.  It has
+ * none of the locale handling and synchronization of the iostream
+ * layer, so printing a number costs little more than copying its
+ * digits.
+ */
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/*
+ * Class: OutputBuffer
+ * -------------------
+ * Collects text and writes it to a file descriptor when the buffer is
+ * full or when flush is called.  In line-buffered mode, which is meant
+ * for terminals, every complete line is written at once instead.  In
+ * asynchronous mode the writing is done by a thread of its own, so
+ * that the interpreter does not wait for a slow reader of its output.
+ */
+
+class OutputBuffer {
+
+public:
+
+/*
+ * Constructor: OutputBuffer
+ * Usage: OutputBuffer out(fd, capacity);
+ * --------------------------------------
+ * Creates an empty buffer of the given capacity for the file
+ * descriptor.  The capacity must be at least MAX_INTEGER_CHARS, so
+ * that any integer can be formatted in place.
+ */
+
+    OutputBuffer(int fd, std::size_t capacity);
+
+/*
+ * Destructor: ~OutputBuffer
+ * Usage: usually implicit
+ * -----------------------
+ * Writes out whatever is left in the buffer and, in asynchronous mode,
+ * waits for the writer thread to finish.
+ */
+
+    ~OutputBuffer();
+
+/*
+ * Method: setLineBuffered
+ * Usage: out.setLineBuffered(flag);
+ * ---------------------------------
+ * Turns line-buffered mode on or off.
+ */
+
+    void setLineBuffered(bool flag);
+
+/*
+ * Method: startWriter
+ * Usage: out.startWriter(chunks);
+ * -------------------------------
+ * Switches to asynchronous mode, in which the contents of the buffer
+ * are handed to a writer thread whenever they would have been
+ * written.  Up to the given number of buffers may wait for the thread
+ * before the interpreter has to wait for it.
+ */
+
+    void startWriter(std::size_t chunks);
+
+/*
+ * Method: flush
+ * Usage: out.flush();
+ * -------------------
+ * Writes the contents of the buffer to the file descriptor, or in
+ * asynchronous mode hands them to the writer thread without waiting.
+ * If the write fails, the contents are dropped.
+ */
+
+    void flush();
+
+/*
+ * Method: sync
+ * Usage: out.sync();
+ * ------------------
+ * Flushes the buffer and waits until everything written to it so far
+ * has reached the file descriptor.  This is the barrier to use before
+ * waiting for input that may depend on the output.
+ */
+
+    void sync();
+
+/*
+ * Operator: <<
+ * Usage: out << value;
+ * --------------------
+ * Appends a string, a character or an integer to the buffer.
+ * Integers are written in decimal, as std::cout would write them.
+ */
+
+    OutputBuffer &operator<<(std::string_view text);
+
+    OutputBuffer &operator<<(const char *text);
+
+    OutputBuffer &operator<<(char ch);
+
+    OutputBuffer &operator<<(int value);
+
+    OutputBuffer &operator<<(long long value);
+
+private:
+
+    struct Writer;
+
+    void append(const char *text, std::size_t length);
+
+    void emit(const char *text, std::size_t length);
+
+    int fd;
+    std::unique_ptr<char[]> buffer;
+    std::size_t capacity;
+    std::size_t used = 0;
+    bool lineBuffered = false;
+    std::unique_ptr<Writer> writer;
+
+};
+
+/*
+ * Function: standardOutput
+ * Usage: standardOutput() << value;
+ * ---------------------------------
+ * Returns the buffer for the standard output, which every part of the
+ * interpreter writes to instead of std::cout.  It is created on first
+ * use and flushed when the program exits through exit or by returning
+ * from main.
+ */
+
+OutputBuffer &standardOutput();
+
+#endif //CODE_OUTPUTBUFFER_HPP
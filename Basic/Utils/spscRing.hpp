@@ -0,0 +1,158 @@
+#ifndef CODE_SPSCRING_HPP
+#define CODE_SPSCRING_HPP
+
+/*
+ * File: spscRing.h
+ * ----------------
+ * This file exports SpscRing, a bounded queue that passes items from
+ * exactly one producer thread to exactly one consumer thread.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/*
+ * Class: SpscRing
+ * ---------------
+ * A ring of slots indexed by two counters: the producer only advances
+ * tail and the consumer only advances head, so as long as the ring is
+ * neither empty nor full, neither side takes a lock.  Items are moved
+ * by swapping them with the slots, which lets the two threads recycle
+ * each other's storage.  A side that has to wait sleeps on a condition
+ * variable instead of spinning, since the other side may need the same
+ * processor to make progress.
+ */
+
+template<typename T>
+class SpscRing {
+
+public:
+
+/*
+ * Constructor: SpscRing
+ * Usage: SpscRing<T> ring(capacity);
+ * ----------------------------------
+ * Creates an empty ring that holds at most capacity items.
+ */
+
+    explicit SpscRing(std::size_t capacity) : slots(capacity) {}
+
+/*
+ * Method: push
+ * Usage: ring.push(item);
+ * -----------------------
+ * Adds item at the end of the ring, waiting while the ring is full.
+ * The item is swapped into the ring, so afterwards it holds whatever
+ * was left in the slot.  Only the producer may call push.
+ */
+
+    void push(T &item) {
+        std::size_t end = tail.load(std::memory_order_relaxed);
+        if (end - head.load() == slots.size()) {
+            waitFor(producerWaiting, [&] { return end - head.load() < slots.size(); });
+        }
+        std::swap(slots[end % slots.size()], item);
+        tail.store(end + 1);
+        wake(consumerWaiting);
+    }
+
+/*
+ * Method: close
+ * Usage: ring.close();
+ * --------------------
+ * Tells the consumer that no more items will be pushed.
+ */
+
+    void close() {
+        closed.store(true);
+        wake(consumerWaiting);
+    }
+
+/*
+ * Method: pop
+ * Usage: if (ring.pop(item)) ...
+ * ------------------------------
+ * Swaps the oldest item of the ring into item and returns true,
+ * waiting while the ring is empty.  Returns false if the ring is empty
+ * and has been closed.  Only the consumer may call pop.
+ */
+
+    bool pop(T &item) {
+        std::size_t start = head.load(std::memory_order_relaxed);
+        if (tail.load() == start) {
+            waitFor(consumerWaiting, [&] { return tail.load() != start || closed.load(); });
+        }
+        return tryPop(item);
+    }
+
+/*
+ * Method: tryPop
+ * Usage: if (ring.tryPop(item)) ...
+ * ---------------------------------
+ * Like pop, but returns false at once if the ring is empty.
+ */
+
+    bool tryPop(T &item) {
+        std::size_t start = head.load(std::memory_order_relaxed);
+        if (tail.load() == start) return false;
+        std::swap(slots[start % slots.size()], item);
+        head.store(start + 1);
+        wake(producerWaiting);
+        return true;
+    }
+
+/*
+ * Method: isEmpty
+ * Usage: if (ring.isEmpty()) ...
+ * ------------------------------
+ * Returns true if the ring holds no items.  The answer is only stable
+ * if the caller is the one side that could change it.
+ */
+
+    bool isEmpty() const {
+        return tail.load() == head.load();
+    }
+
+private:
+
+/*
+ * Implementation notes: waitFor, wake
+ * -----------------------------------
+ * A waiting side raises its flag before it tests the condition again,
+ * and the other side changes the counters before it tests the flag.
+ * All these operations are sequentially consistent, so at least one
+ * side sees the other's change: either the waiter finds the condition
+ * true, or the other side takes the mutex and notifies it.
+ */
+
+    template<typename Predicate>
+    void waitFor(std::atomic<bool> &waiting, Predicate ready) {
+        std::unique_lock<std::mutex> lock(mutex);
+        waiting.store(true);
+        changed.wait(lock, ready);
+        waiting.store(false);
+    }
+
+    void wake(std::atomic<bool> &waiting) {
+        if (waiting.load()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            changed.notify_all();
+        }
+    }
+
+    std::vector<T> slots;
+    std::atomic<std::size_t> head{0};
+    std::atomic<std::size_t> tail{0};
+    std::atomic<bool> closed{false};
+    std::atomic<bool> producerWaiting{false};
+    std::atomic<bool> consumerWaiting{false};
+    std::mutex mutex;
+    std::condition_variable changed;
+
+};
+
+#endif //CODE_SPSCRING_HPP
@@ -5,6 +5,7 @@
  */
 
 #include <cctype>
+#include <charconv>
 #include <iomanip>
 #include <iostream>
 #include "error.hpp"
@@ -12,47 +13,191 @@
 
 /* Function prototypes */
 
+static std::size_t skipSpaces(std::string_view str, std::size_t pos);
+static bool isUnderflow(std::string_view number);
+
 /*
  * Implementation notes: numeric conversion
  * ----------------------------------------
- * These functions use the <sstream> library to perform the conversion.
+ * These functions use formatInteger, std::to_chars and
+ * std::from_chars, which ignore the locale and need no stream
+ * objects.  The parsers accept exactly what reading the number from
+ * a stream used to accept: whitespace around the number, an optional
+ * sign and, for reals, no "inf", "nan" or hexadecimal forms.  A
+ * number too large for its type is an error, while a real too small
+ * to represent becomes zero.
  */
 
 std::string integerToString(int n) {
-    std::ostringstream stream;
-    stream << n;
-    return stream.str();
+    char buffer[MAX_INTEGER_CHARS];
+    return std::string(buffer, formatInteger(buffer, n));
 }
 
-int stringToInteger(std::string str) {
+/*
+ * Implementation notes: formatInteger
+ * -----------------------------------
+ * The digits are produced two at a time from the end, by dividing by
+ * 100 and looking the remainder up in a table of the pairs "00" to
+ * "99", which halves the number of divisions.  Values that fit in 32
+ * bits, which include every BASIC value, are converted with 32-bit
+ * divisions, which are cheaper.  The magnitude of n is computed in
+ * unsigned arithmetic, where it is exact even for the most negative
+ * value.
+ */
 
-    std::istringstream stream(str);
-    int value;
-    stream >> value;
-    if (!stream.eof()) stream >> std::ws;
-    if (stream.fail() || !stream.eof()) {
-        error("stringToInteger: Illegal integer format (" + str + ")");
+static const char DIGIT_PAIRS[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+template<typename Unsigned>
+static char *writeDigits(char *buffer, Unsigned magnitude) {
+    int length = 1;
+    for (Unsigned rest = magnitude; rest >= 10; rest /= 10000) {
+        if (rest < 100) {
+            length += 1;
+            break;
+        }
+        if (rest < 1000) {
+            length += 2;
+            break;
+        }
+        if (rest < 10000) {
+            length += 3;
+            break;
+        }
+        length += 4;
+    }
+    char *end = buffer + length;
+    char *cp = end;
+    while (magnitude >= 100) {
+        const char *pair = DIGIT_PAIRS + 2 * (magnitude % 100);
+        magnitude /= 100;
+        *--cp = pair[1];
+        *--cp = pair[0];
+    }
+    if (magnitude >= 10) {
+        *--cp = DIGIT_PAIRS[2 * magnitude + 1];
+        *--cp = DIGIT_PAIRS[2 * magnitude];
+    } else {
+        *--cp = char('0' + magnitude);
+    }
+    return end;
+}
+
+char *formatInteger(char *buffer, long long n) {
+    unsigned long long magnitude = n;
+    if (n < 0) {
+        *buffer++ = '-';
+        magnitude = 0 - magnitude;
+    }
+    if (magnitude <= 0xFFFFFFFFu) return writeDigits(buffer, (unsigned) magnitude);
+    return writeDigits(buffer, magnitude);
+}
+
+int stringToInteger(std::string_view str) {
+    std::size_t start = skipSpaces(str, 0);
+    std::size_t digits = start;
+    if (digits < str.length() && (str[digits] == '+' || str[digits] == '-')) digits++;
+    if (digits > start && str[start] == '+') start = digits;
+    int value = 0;
+    std::from_chars_result result = {str.data() + digits, std::errc::invalid_argument};
+    if (digits < str.length() && isdigit((unsigned char) str[digits])) {
+        result = std::from_chars(str.data() + start, str.data() + str.length(), value);
+    }
+    std::size_t end = result.ptr - str.data();
+    if (result.ec != std::errc() || skipSpaces(str, end) != str.length()) {
+        error("stringToInteger: Illegal integer format (" + std::string(str) + ")");
     }
     return value;
 }
 
 std::string realToString(double d) {
-    std::ostringstream stream;
-    stream << std::uppercase << d;
-    return stream.str();
+    char buffer[32];
+    char *end = std::to_chars(buffer, buffer + sizeof buffer, d, std::chars_format::general, 6).ptr;
+    for (char *cp = buffer; cp < end; cp++) {
+        *cp = toupper(*cp);
+    }
+    return std::string(buffer, end);
 }
 
-double stringToReal(std::string str) {
-    std::istringstream stream(str);
-    double value;
-    stream >> value;
-    if (!stream.eof()) stream >> std::ws;
-    if (stream.fail() || !stream.eof()) {
-        error("stringToReal: Illegal floating-point format (" + str + ")");
+double stringToReal(std::string_view str) {
+    std::size_t start = skipSpaces(str, 0);
+    std::size_t digits = start;
+    if (digits < str.length() && (str[digits] == '+' || str[digits] == '-')) digits++;
+    if (digits > start && str[start] == '+') start = digits;
+    double value = 0;
+    std::from_chars_result result = {str.data() + digits, std::errc::invalid_argument};
+    if (digits < str.length() && (isdigit((unsigned char) str[digits]) || str[digits] == '.')) {
+        result = std::from_chars(str.data() + start, str.data() + str.length(), value);
+    }
+    std::size_t end = result.ptr - str.data();
+    if (result.ec == std::errc::result_out_of_range && isUnderflow(str.substr(digits, end - digits))) {
+        value = (str[start] == '-') ? -0.0 : 0.0;
+        result.ec = std::errc();
+    }
+    if (result.ec != std::errc() || skipSpaces(str, end) != str.length()) {
+        error("stringToReal: Illegal floating-point format (" + std::string(str) + ")");
     }
     return value;
 }
 
+/*
+ * Function: skipSpaces
+ * Usage: pos = skipSpaces(str, pos);
+ * ----------------------------------
+ * Returns the position of the first character at or after pos that
+ * is not whitespace in the C locale, or the length of the string.
+ */
+
+static std::size_t skipSpaces(std::string_view str, std::size_t pos) {
+    while (pos < str.length() && (str[pos] == ' ' || (str[pos] >= '\t' && str[pos] <= '\r'))) {
+        pos++;
+    }
+    return pos;
+}
+
+/*
+ * Function: isUnderflow
+ * Usage: if (isUnderflow(number)) ...
+ * -----------------------------------
+ * Decides whether an unsigned decimal number that std::from_chars found
+ * out of range is too small rather than too large, by computing the
+ * power of ten of its first significant digit.
+ */
+
+static bool isUnderflow(std::string_view number) {
+    long scale = 0;
+    std::size_t i = 0;
+    while (i < number.length() && number[i] == '0') i++;
+    while (i < number.length() && isdigit((unsigned char) number[i])) {
+        scale++;
+        i++;
+    }
+    if (i < number.length() && number[i] == '.') {
+        i++;
+        if (scale == 0) {
+            while (i < number.length() && number[i] == '0') {
+                scale--;
+                i++;
+            }
+        }
+        while (i < number.length() && isdigit((unsigned char) number[i])) i++;
+    }
+    long exponent = 0;
+    if (i < number.length() && (number[i] == 'E' || number[i] == 'e')) {
+        i++;
+        bool negative = (i < number.length() && number[i] == '-');
+        if (i < number.length() && (number[i] == '-' || number[i] == '+')) i++;
+        while (i < number.length() && isdigit((unsigned char) number[i])) {
+            if (exponent < 1000000) exponent = 10 * exponent + (number[i] - '0');
+            i++;
+        }
+        if (negative) exponent = -exponent;
+    }
+    return scale + exponent <= 0;
+}
+
 /*
  * Implementation notes: case conversion
  * -------------------------------------
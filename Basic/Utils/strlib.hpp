@@ -10,6 +10,7 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 
 /*
  * Function: integerToString
@@ -22,6 +23,21 @@
 
 std::string integerToString(int n);
 
+/*
+ * Function: formatInteger
+ * Usage: char *end = formatInteger(buffer, n);
+ * --------------------------------------------
+ * Writes the decimal form of n, with a leading minus sign if it is
+ * negative, to the character array and returns a pointer just past the
+ * last character written.  No terminating null character is added.
+ * The array must have room for MAX_INTEGER_CHARS characters, which is
+ * enough for any long long.
+ */
+
+const int MAX_INTEGER_CHARS = 20;
+
+char *formatInteger(char *buffer, long long n);
+
 /*
  * Function: stringToInteger
  * Usage: int n = stringToInteger(str);
@@ -32,7 +48,7 @@ std::string integerToString(int n);
  * appropriate message.
  */
 
-int stringToInteger(std::string str);
+int stringToInteger(std::string_view str);
 
 /*
  * Function: realToString
@@ -55,7 +71,7 @@ std::string realToString(double d);
  * calls <code>error</code> with an appropriate message.
  */
 
-double stringToReal(std::string str);
+double stringToReal(std::string_view str);
 
 /*
  * Function: toUpperCase
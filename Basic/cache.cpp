@@ -0,0 +1,59 @@
+/*
+ * File: cache.cpp
+ * ---------------
+ * This file implements the cache.h interface.  The entries are kept
+ * in a list ordered by their last use, and a hash table indexed by
+ * the statement text points to the list nodes.  The keys of the hash
+ * table are views of the text stored in the nodes, which never move.
+ */
+
+#include "cache.hpp"
+#include "Utils/error.hpp"
+
+ParseCache::ParseCache(std::size_t capacity) : capacity(capacity) {}
+
+const Statement *ParseCache::lookup(std::string_view body) {
+    auto iter = index.find(body);
+    if (iter == index.end()) {
+        misses++;
+        return nullptr;
+    }
+    hits++;
+    entries.splice(entries.begin(), entries, iter->second);
+    return &entries.front().stmt;
+}
+
+void ParseCache::insert(std::string_view body, const Statement &stmt) {
+    if (capacity == 0 || index.find(body) != index.end()) return;
+    if (entries.size() == capacity) {
+        index.erase(std::string_view(entries.back().body));
+        entries.pop_back();
+    }
+    try {
+        entries.push_front(Entry{Key(body), stmt});
+        try {
+            index.emplace(std::string_view(entries.front().body), entries.begin());
+        } catch (ErrorException &) {
+            entries.pop_front();
+        }
+    } catch (ErrorException &) {
+        /* No room for the entry: the statement is simply not cached */
+    }
+}
+
+void ParseCache::clear() {
+    EntryIndex().swap(index);
+    entries.clear();
+}
+
+std::size_t ParseCache::getEntryCount() const {
+    return entries.size();
+}
+
+long ParseCache::getHits() const {
+    return hits;
+}
+
+long ParseCache::getMisses() const {
+    return misses;
+}
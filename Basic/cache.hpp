@@ -0,0 +1,114 @@
+/*
+ * File: cache.h
+ * -------------
+ * This interface exports the ParseCache class, which remembers the
+ * statements parsed from recently entered program lines.
+ */
+
+#ifndef _cache_h
+#define _cache_h
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "memory.hpp"
+#include "statement.hpp"
+
+/*
+ * Class: ParseCache
+ * -----------------
+ * This class maps the text of a statement, which is everything on a
+ * program line after the line number, to the statement parsed from it.
+ * Since statements share their immutable expression trees, a statement
+ * found in the cache can be copied into the program instead of parsing
+ * the text again.  The cache holds a bounded number of entries and
+ * drops the least recently used one when it is full.  It belongs to
+ * the interpreter rather than to a program, so it survives CLEAR.
+ */
+
+class ParseCache {
+
+public:
+
+/*
+ * Constructor: ParseCache
+ * Usage: ParseCache cache(capacity);
+ * ----------------------------------
+ * Creates an empty cache that holds at most capacity statements.  A
+ * capacity of 0 disables the cache.
+ */
+
+    ParseCache(std::size_t capacity);
+
+/*
+ * Method: lookup
+ * Usage: const Statement *stmt = cache.lookup(body);
+ * --------------------------------------------------
+ * Returns the statement cached for the statement text, or nullptr if
+ * there is none.  Each call counts as a hit or a miss.
+ */
+
+    const Statement *lookup(std::string_view body);
+
+/*
+ * Method: insert
+ * Usage: cache.insert(body, stmt);
+ * --------------------------------
+ * Remembers a copy of the statement parsed from the statement text.
+ * If the copy does not fit in the memory quota, nothing is cached.
+ */
+
+    void insert(std::string_view body, const Statement &stmt);
+
+/*
+ * Method: clear
+ * Usage: cache.clear();
+ * ---------------------
+ * Removes every entry from the cache, without resetting the counts.
+ */
+
+    void clear();
+
+/*
+ * Methods: getEntryCount, getHits, getMisses
+ * Usage: std::size_t entries = cache.getEntryCount();
+ *        long hits = cache.getHits();
+ *        long misses = cache.getMisses();
+ * --------------------------------------------------
+ * Return the number of cached statements and the number of lookups
+ * that did or did not find a statement.
+ */
+
+    std::size_t getEntryCount() const;
+
+    long getHits() const;
+
+    long getMisses() const;
+
+private:
+
+    typedef std::basic_string<char, std::char_traits<char>, AccountingAllocator<char, CACHE_MEMORY>> Key;
+
+    struct Entry {
+        Key body;
+        Statement stmt;
+    };
+
+    typedef std::list<Entry, AccountingAllocator<Entry, CACHE_MEMORY>> EntryList;
+
+    typedef std::unordered_map<std::string_view, EntryList::iterator,
+            std::hash<std::string_view>, std::equal_to<std::string_view>,
+            AccountingAllocator<std::pair<const std::string_view, EntryList::iterator>, CACHE_MEMORY>> EntryIndex;
+
+    EntryList entries;      /* Most recently used first        */
+    EntryIndex index;       /* Views of the keys in entries    */
+    std::size_t capacity;
+    long hits = 0;
+    long misses = 0;
+
+};
+
+#endif
@@ -7,35 +7,170 @@
  */
 
 
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
 #include "evalstate.hpp"
+#include "memory.hpp"
+#include "Utils/error.hpp"
+#include "Utils/inputBuffer.hpp"
+#include "Utils/outputBuffer.hpp"
 
 
 //using namespace std;
 
+/*
+ * Constant: FILE_BUFFER_CAPACITY
+ * ------------------------------
+ * The size of the buffer of an open file, which is also the size of
+ * the blocks in which the file is read or written.  The buffer is
+ * charged to FILE_MEMORY for as long as the file is open.
+ */
+
+static const std::size_t FILE_BUFFER_CAPACITY = 1 << 20;
+
+/*
+ * Type: Channel
+ * -------------
+ * A file opened by OPEN.  Only one of the two buffers is used,
+ * depending on the mode.  The channel owns the descriptor and the
+ * charge for the buffer from the moment each is taken, so a channel
+ * that is destroyed before it is fully set up gives back whatever it
+ * holds.  The output buffer is flushed before the descriptor is
+ * closed.
+ */
+
+struct EvalState::Channel {
+    FileMode mode;
+    int fd;
+    bool charged;
+    std::unique_ptr<InputBuffer> in;
+    std::unique_ptr<OutputBuffer> out;
+
+    ~Channel() {
+        out.reset();
+        in.reset();
+        if (fd >= 0) ::close(fd);
+        if (charged) releaseMemory(FILE_BUFFER_CAPACITY, FILE_MEMORY);
+    }
+};
+
 /* Implementation of the EvalState class */
 
 EvalState::EvalState() {
-    /* Empty */
+    sweep = symbolTable.end();
 }
 
 EvalState::~EvalState() {
     /* Empty */
 }
 
-void EvalState::setValue(std::string var, int value) {
-    if(isDefined(var)) symbolTable[var] = value;
-    else symbolTable.emplace(var,value);
+void EvalState::setValue(std::string_view var, int value) {
+    auto iter = symbolTable.find(var);
+    if (iter == symbolTable.end()) {
+        iter = symbolTable.emplace(std::string(var), Binding()).first;
+    }
+    iter->second.value = value;
+    iter->second.generation = generation;
 }
 
-int EvalState::getValue(std::string var) {
-    if(isDefined(var)) return symbolTable[var];
+int EvalState::getValue(std::string_view var) {
+    auto iter = symbolTable.find(var);
+    if (iter != symbolTable.end() && iter->second.generation == generation) return iter->second.value;
     else return 0;
 }
 
-bool EvalState::isDefined(std::string var) {
-    return symbolTable.find(var)!=symbolTable.end();
+bool EvalState::isDefined(std::string_view var) {
+    auto iter = symbolTable.find(var);
+    return iter != symbolTable.end() && iter->second.generation == generation;
+}
+
+int EvalState::getVariableCount() const {
+    int count = 0;
+    for (const auto &entry: symbolTable) {
+        if (entry.second.generation == generation) count++;
+    }
+    return count;
+}
+
+void EvalState::setPrompting(bool flag) {
+    prompting = flag;
+}
+
+bool EvalState::isPrompting() const {
+    return prompting;
 }
 
 void EvalState::Clear() {
-    symbolTable.clear();
-}
\ No newline at end of file
+    generation++;
+    sweep = symbolTable.begin();
+}
+
+/*
+ * Implementation notes: reclaim
+ * -----------------------------
+ * The sweep iterator walks the table once after each Clear and erases
+ * the bindings of older generations.  Bindings set again since the
+ * Clear are kept.  Inserting into a std::map never invalidates the
+ * iterator, so the sweep can be spread over many calls.
+ */
+
+void EvalState::reclaim(int budget) {
+    while (budget != 0 && sweep != symbolTable.end()) {
+        if (sweep->second.generation != generation) {
+            sweep = symbolTable.erase(sweep);
+        } else {
+            ++sweep;
+        }
+        budget--;
+    }
+}
+
+void EvalState::openChannel(int channel, const std::string &path, FileMode mode) {
+    std::unique_ptr<Channel> &slot = channels[channel - 1];
+    if (slot != nullptr) error("CHANNEL ALREADY OPEN");
+    int flags = O_RDONLY;
+    if (mode == FILE_OUTPUT) flags = O_WRONLY | O_CREAT | O_TRUNC;
+    if (mode == FILE_APPEND) flags = O_WRONLY | O_CREAT | O_APPEND;
+    std::unique_ptr<Channel> file(new Channel{mode, -1, false, nullptr, nullptr});
+    chargeMemory(FILE_BUFFER_CAPACITY, FILE_MEMORY);
+    file->charged = true;
+    do {
+        file->fd = ::open(path.c_str(), flags | O_CLOEXEC, 0666);
+    } while (file->fd < 0 && errno == EINTR);
+    if (file->fd < 0) error("CANNOT OPEN FILE");
+    if (mode == FILE_INPUT) {
+        file->in.reset(new InputBuffer(file->fd, FILE_BUFFER_CAPACITY));
+    } else {
+        file->out.reset(new OutputBuffer(file->fd, FILE_BUFFER_CAPACITY));
+    }
+    slot = std::move(file);
+}
+
+void EvalState::closeChannel(int channel) {
+    channels[channel - 1].reset();
+}
+
+void EvalState::closeChannels() {
+    for (std::unique_ptr<Channel> &channel: channels) {
+        channel.reset();
+    }
+}
+
+InputBuffer &EvalState::getInputChannel(int channel) {
+    Channel &file = getChannel(channel);
+    if (file.mode != FILE_INPUT) error("BAD FILE MODE");
+    return *file.in;
+}
+
+OutputBuffer &EvalState::getOutputChannel(int channel) {
+    Channel &file = getChannel(channel);
+    if (file.mode == FILE_INPUT) error("BAD FILE MODE");
+    return *file.out;
+}
+
+EvalState::Channel &EvalState::getChannel(int channel) {
+    Channel *file = channels[channel - 1].get();
+    if (file == nullptr) error("CHANNEL NOT OPEN");
+    return *file;
+}
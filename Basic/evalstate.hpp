@@ -9,8 +9,26 @@
 #ifndef _evalstate_h
 #define _evalstate_h
 
+#include <memory>
 #include <string>
+#include <string_view>
 #include <map>
+#include "memory.hpp"
+
+class InputBuffer;
+
+class OutputBuffer;
+
+/*
+ * Type: FileMode
+ * --------------
+ * The ways in which OPEN can open a file: for reading, for writing
+ * from the start, or for writing after its current end.
+ */
+
+enum FileMode {
+    FILE_INPUT, FILE_OUTPUT, FILE_APPEND
+};
 
 /*
  * Class: EvalState
@@ -21,13 +39,22 @@
  * version, the only information maintained by the EvalState class
  * is a symbol table that maps variable names into their values.
  * In your implementation, you may include additional information
- * in the EvalState class.
+ * in the EvalState class.  It also holds the table of files opened
+ * with OPEN, which are numbered from 1 to MAX_CHANNELS.
  */
 
 class EvalState {
 
 public:
 
+/*
+ * Constant: MAX_CHANNELS
+ * ----------------------
+ * The number of files that can be open at the same time.
+ */
+
+    static const int MAX_CHANNELS = 16;
+
 /*
  * Constructor: EvalState
  * Usage: EvalState state;
@@ -53,7 +80,7 @@ public:
  * Sets the value associated with the specified var.
  */
 
-    void setValue(std::string var, int value);
+    void setValue(std::string_view var, int value);
 
 /*
  * Method: getValue
@@ -62,7 +89,7 @@ public:
  * Returns the value associated with the specified variable.
  */
 
-    int getValue(std::string var);
+    int getValue(std::string_view var);
 
 /*
  * Method: isDefined
@@ -71,13 +98,116 @@ public:
  * Returns true if the specified variable is defined.
  */
 
-    bool isDefined(std::string var);
+    bool isDefined(std::string_view var);
+
+/*
+ * Method: getVariableCount
+ * Usage: int count = state.getVariableCount();
+ * --------------------------------------------
+ * Returns the number of variables that are currently defined.
+ */
+
+    int getVariableCount() const;
+
+/*
+ * Methods: setPrompting, isPrompting
+ * Usage: state.setPrompting(flag);
+ *        if (state.isPrompting()) ...
+ * -----------------------------------
+ * Set and return whether INPUT prints its " ? " prompt, which it does
+ * unless the interpreter runs in headless mode.
+ */
+
+    void setPrompting(bool flag);
+
+    bool isPrompting() const;
+
+/*
+ * Method: Clear
+ * Usage: state.Clear();
+ * ---------------------
+ * Removes every variable binding in constant time.  The bindings are
+ * only marked as belonging to an older generation; their memory is
+ * freed later by reclaim.
+ */
 
     void Clear();
 
+/*
+ * Method: reclaim
+ * Usage: state.reclaim(budget);
+ * -----------------------------
+ * Frees the storage of at most budget bindings left behind by Clear.
+ * A negative budget frees all of them.
+ */
+
+    void reclaim(int budget);
+
+/*
+ * Method: openChannel
+ * Usage: state.openChannel(channel, path, mode);
+ * ----------------------------------------------
+ * Opens the file at path and assigns it to the channel, which must be
+ * between 1 and MAX_CHANNELS.  An OUTPUT file is created or emptied,
+ * and an APPEND file is created if it does not exist.  It is an error
+ * if the channel is already in use or the file cannot be opened.
+ */
+
+    void openChannel(int channel, const std::string &path, FileMode mode);
+
+/*
+ * Methods: closeChannel, closeChannels
+ * Usage: state.closeChannel(channel);
+ *        state.closeChannels();
+ * ------------------------------------
+ * Write out what is left in the buffer of the file on the channel, or
+ * of every open file, and close it.  Closing a channel that is not in
+ * use does nothing.
+ */
+
+    void closeChannel(int channel);
+
+    void closeChannels();
+
+/*
+ * Methods: getInputChannel, getOutputChannel
+ * Usage: InputBuffer &in = state.getInputChannel(channel);
+ *        OutputBuffer &out = state.getOutputChannel(channel);
+ * -------------------------------------------------------
+ * Return the buffer of the file on the channel.  It is an error if no
+ * file is open on the channel or if it was opened the other way.
+ */
+
+    InputBuffer &getInputChannel(int channel);
+
+    OutputBuffer &getOutputChannel(int channel);
+
 private:
 
-    std::map<std::string, int> symbolTable;
+    struct Channel;
+
+    Channel &getChannel(int channel);
+
+/*
+ * Type: Binding
+ * -------------
+ * The value of a variable and the generation in which it was set.
+ * A binding from an older generation is treated as undefined.
+ */
+
+    struct Binding {
+        int value;
+        unsigned generation;
+    };
+
+    typedef std::map<std::string, Binding, std::less<>,
+            AccountingAllocator<std::pair<const std::string, Binding>, SYMBOL_MEMORY>> SymbolTable;
+
+    SymbolTable symbolTable;
+    unsigned generation = 0;
+    bool prompting = true;
+    SymbolTable::iterator sweep;     /* Next binding reclaim looks at */
+    std::unique_ptr<Channel> channels[MAX_CHANNELS];
 
 };
 
@@ -10,13 +10,35 @@
 /*
  * Implementation notes: the Expression class
  * ------------------------------------------
- * The Expression class declares no instance variables and needs no code.
+ * The Expression class declares no instance variables.  Its only code
+ * is the pair of allocation operators that account for the nodes.
  */
 
 Expression::Expression() = default;
 
 Expression::~Expression() = default;
 
+std::atomic<long> Expression::nodeCount[COMPOUND + 1];
+
+long Expression::getNodeCount(ExpressionType type) {
+    return nodeCount[type].load();
+}
+
+void *Expression::operator new(std::size_t size) {
+    chargeMemory(size, EXPRESSION_MEMORY);
+    try {
+        return ::operator new(size);
+    } catch (...) {
+        releaseMemory(size, EXPRESSION_MEMORY);
+        throw;
+    }
+}
+
+void Expression::operator delete(void *ptr, std::size_t size) {
+    ::operator delete(ptr);
+    releaseMemory(size, EXPRESSION_MEMORY);
+}
+
 /*
  * Implementation notes: the ConstantExp subclass
  * ----------------------------------------------
@@ -27,21 +49,26 @@ Expression::~Expression() = default;
 
 ConstantExp::ConstantExp(int value) {
     this->value = value;
+    nodeCount[CONSTANT]++;
+}
+
+ConstantExp::~ConstantExp() {
+    nodeCount[CONSTANT]--;
 }
 
-int ConstantExp::eval(EvalState &state) {
+int ConstantExp::eval(EvalState &state) const {
     return value;
 }
 
-std::string ConstantExp::toString() {
+std::string ConstantExp::toString() const {
     return integerToString(value);
 }
 
-ExpressionType ConstantExp::getType() {
+ExpressionType ConstantExp::getType() const {
     return CONSTANT;
 }
 
-int ConstantExp::getValue() {
+int ConstantExp::getValue() const {
     return value;
 }
 
@@ -55,22 +82,27 @@ int ConstantExp::getValue() {
 
 IdentifierExp::IdentifierExp(std::string name) {
     this->name = name;
+    nodeCount[IDENTIFIER]++;
+}
+
+IdentifierExp::~IdentifierExp() {
+    nodeCount[IDENTIFIER]--;
 }
 
-int IdentifierExp::eval(EvalState &state) {
+int IdentifierExp::eval(EvalState &state) const {
     if (!state.isDefined(name)) error("VARIABLE NOT DEFINED");
     return state.getValue(name);
 }
 
-std::string IdentifierExp::toString() {
+std::string IdentifierExp::toString() const {
     return name;
 }
 
-ExpressionType IdentifierExp::getType() {
+ExpressionType IdentifierExp::getType() const {
     return IDENTIFIER;
 }
 
-std::string IdentifierExp::getName() {
+std::string IdentifierExp::getName() const {
     return name;
 }
 
@@ -82,15 +114,15 @@ std::string IdentifierExp::getName() {
  * evaluates the subexpressions recursively and then applies the operator.
  */
 
-CompoundExp::CompoundExp(std::string op, Expression *lhs, Expression *rhs) {
+CompoundExp::CompoundExp(std::string op, std::unique_ptr<Expression> lhs, std::unique_ptr<Expression> rhs) {
     this->op = op;
-    this->lhs = lhs;
-    this->rhs = rhs;
+    this->lhs = std::move(lhs);
+    this->rhs = std::move(rhs);
+    nodeCount[COMPOUND]++;
 }
 
 CompoundExp::~CompoundExp() {
-    delete lhs;
-    delete rhs;
+    nodeCount[COMPOUND]--;
 }
 
 /*
@@ -101,7 +133,7 @@ CompoundExp::~CompoundExp() {
  * the assignment operator does not evaluate its left operand.
  */
 
-int CompoundExp::eval(EvalState &state) {
+int CompoundExp::eval(EvalState &state) const {
     if (op == "=") {
         if (lhs->getType() != IDENTIFIER) {
             error("Illegal variable in assignment");
@@ -109,7 +141,7 @@ int CompoundExp::eval(EvalState &state) {
         if (lhs->getType() == IDENTIFIER && lhs->toString() == "LET")
             error("SYNTAX ERROR");
         int val = rhs->eval(state);
-        state.setValue(((IdentifierExp *) lhs)->getName(), val);
+        state.setValue(((IdentifierExp *) lhs.get())->getName(), val);
         return val;
     }
     int left = lhs->eval(state);
@@ -124,22 +156,22 @@ int CompoundExp::eval(EvalState &state) {
     return 0;
 }
 
-std::string CompoundExp::toString() {
+std::string CompoundExp::toString() const {
     return '(' + lhs->toString() + ' ' + op + ' ' + rhs->toString() + ')';
 }
 
-ExpressionType CompoundExp::getType() {
+ExpressionType CompoundExp::getType() const {
     return COMPOUND;
 }
 
-std::string CompoundExp::getOp() {
+std::string CompoundExp::getOp() const {
     return op;
 }
 
-Expression *CompoundExp::getLHS() {
-    return lhs;
+const Expression *CompoundExp::getLHS() const {
+    return lhs.get();
 }
 
-Expression *CompoundExp::getRHS() {
-    return rhs;
+const Expression *CompoundExp::getRHS() const {
+    return rhs.get();
 }
@@ -9,9 +9,12 @@
 #ifndef _exp_h
 #define _exp_h
 
+#include <atomic>
+#include <memory>
 #include <string>
 #include "Utils/error.hpp"
 #include "evalstate.hpp"
+#include "memory.hpp"
 #include "Utils/strlib.hpp"
 
 /*
@@ -72,6 +75,17 @@ public:
 
     virtual ~Expression();
 
+/*
+ * Operators: new, delete
+ * ----------------------
+ * Every expression node is allocated through these operators, which
+ * charge the size of the node to the interpreter's memory account.
+ */
+
+    static void *operator new(std::size_t size);
+
+    static void operator delete(void *ptr, std::size_t size);
+
 /*
  * Method: eval
  * Usage: int value = exp->eval(state);
@@ -80,7 +94,7 @@ public:
  * the specified EvalState object.
  */
 
-    virtual int eval(EvalState &state) = 0;
+    virtual int eval(EvalState &state) const = 0;
 
 /*
  * Method: toString
@@ -89,7 +103,7 @@ public:
  * Returns a string representation of this expression.
  */
 
-    virtual std::string toString() = 0;
+    virtual std::string toString() const = 0;
 
 /*
  * Method: type
@@ -99,7 +113,21 @@ public:
  * CONSTANT, IDENTIFIER, or COMPOUND.
  */
 
-    virtual ExpressionType getType() = 0;
+    virtual ExpressionType getType() const = 0;
+
+/*
+ * Method: getNodeCount
+ * Usage: long count = Expression::getNodeCount(type);
+ * ---------------------------------------------------
+ * Returns the number of expression nodes of the specified type
+ * that currently exist.
+ */
+
+    static long getNodeCount(ExpressionType type);
+
+protected:
+
+    static std::atomic<long> nodeCount[COMPOUND + 1];
 
 };
 
@@ -123,6 +151,8 @@ public:
 
     ConstantExp(int value);
 
+    virtual ~ConstantExp();
+
 /*
  * Prototypes for the virtual methods
  * ----------------------------------
@@ -130,11 +160,11 @@ public:
  * base class and don't require additional documentation.
  */
 
-    virtual int eval(EvalState &state);
+    virtual int eval(EvalState &state) const;
 
-    virtual std::string toString();
+    virtual std::string toString() const;
 
-    virtual ExpressionType getType();
+    virtual ExpressionType getType() const;
 
 /*
  * Method: getValue
@@ -144,7 +174,7 @@ public:
  * only to an object known to be a ConstantExp.
  */
 
-    int getValue();
+    int getValue() const;
 
 private:
 
@@ -172,6 +202,8 @@ public:
 
     IdentifierExp(std::string name);
 
+    virtual ~IdentifierExp();
+
 /*
  * Prototypes for the virtual methods
  * ----------------------------------
@@ -179,11 +211,11 @@ public:
  * base class and don't require additional documentation.
  */
 
-    virtual int eval(EvalState &state);
+    virtual int eval(EvalState &state) const;
 
-    virtual std::string toString();
+    virtual std::string toString() const;
 
-    virtual ExpressionType getType();
+    virtual ExpressionType getType() const;
 
 /*
  * Method: getName
@@ -193,7 +225,7 @@ public:
  * to an object known to be an IdentifierExp.
  */
 
-    std::string getName();
+    std::string getName() const;
 
 private:
 
@@ -214,14 +246,15 @@ public:
 
 /*
  * Constructor: CompoundExp
- * Usage: Expression *exp = new CompoundExp(op, lhs, rhs);
- * -------------------------------------------------------
+ * Usage: Expression *exp = new CompoundExp(op, std::move(lhs), std::move(rhs));
+ * -----------------------------------------------------------------------------
  * The constructor initializes a new compound expression
  * which is composed of the operator (op) and the left and
- * right subexpression (lhs and rhs).
+ * right subexpression (lhs and rhs).  The compound expression
+ * takes ownership of both subexpressions.
  */
 
-    CompoundExp(std::string op, Expression *lhs, Expression *rhs);
+    CompoundExp(std::string op, std::unique_ptr<Expression> lhs, std::unique_ptr<Expression> rhs);
 
 /*
  * Prototypes for the virtual methods
@@ -232,33 +265,48 @@ public:
 
     virtual ~CompoundExp();
 
-    virtual int eval(EvalState &state);
+    virtual int eval(EvalState &state) const;
 
-    virtual std::string toString();
+    virtual std::string toString() const;
 
-    virtual ExpressionType getType();
+    virtual ExpressionType getType() const;
 
 /*
  * Methods: getOp, getLHS, getRHS
  * Usage: string op = ((CompoundExp *) exp)->getOp();
- *        Expression *lhs = ((CompoundExp *) exp)->getLHS();
- *        Expression *rhs = ((CompoundExp *) exp)->getRHS();
+ *        const Expression *lhs = ((CompoundExp *) exp)->getLHS();
+ *        const Expression *rhs = ((CompoundExp *) exp)->getRHS();
  * ---------------------------------------------------------
  * These methods return the components of a compound node and can
  * be applied only to an object known to be a CompoundExp.
  */
 
-    std::string getOp();
+    std::string getOp() const;
 
-    Expression *getLHS();
+    const Expression *getLHS() const;
 
-    Expression *getRHS();
+    const Expression *getRHS() const;
 
 private:
 
     std::string op;
-    Expression *lhs, *rhs;
+    std::unique_ptr<Expression> lhs, rhs;
 
 };
 
+/*
+ * Function: shareExpression
+ * Usage: std::shared_ptr<const Expression> exp = shareExpression(std::move(tree));
+ * --------------------------------------------------------------------------------
+ * Turns an expression tree owned by a unique_ptr into an immutable tree
+ * that can be shared by several statements.  The control block of the
+ * shared_ptr is charged to the expression memory like the nodes are.
+ */
+
+template<typename T>
+std::shared_ptr<const T> shareExpression(std::unique_ptr<T> exp) {
+    return std::shared_ptr<const T>(exp.release(), std::default_delete<T>(),
+                                    AccountingAllocator<T, EXPRESSION_MEMORY>());
+}
+
 #endif
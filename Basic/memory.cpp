@@ -0,0 +1,46 @@
+/*
+ * File: memory.cpp
+ * ----------------
+ * This file implements the memory.h interface.  The counters are
+ * atomic so that the account stays correct if allocations happen
+ * on more than one thread.
+ */
+
+#include <atomic>
+#include "memory.hpp"
+#include "Utils/error.hpp"
+
+static std::atomic<std::size_t> usage(0);
+static std::atomic<std::size_t> categoryUsage[MEMORY_CATEGORIES];
+static std::atomic<std::size_t> quota(0);
+
+void chargeMemory(std::size_t bytes, MemoryCategory category) {
+    std::size_t before = usage.fetch_add(bytes);
+    std::size_t limit = quota.load();
+    if (limit != 0 && before + bytes > limit) {
+        usage.fetch_sub(bytes);
+        error("OUT OF MEMORY");
+    }
+    categoryUsage[category].fetch_add(bytes);
+}
+
+void releaseMemory(std::size_t bytes, MemoryCategory category) {
+    categoryUsage[category].fetch_sub(bytes);
+    usage.fetch_sub(bytes);
+}
+
+std::size_t getMemoryUsage() {
+    return usage.load();
+}
+
+std::size_t getMemoryUsage(MemoryCategory category) {
+    return categoryUsage[category].load();
+}
+
+void setMemoryQuota(std::size_t bytes) {
+    quota.store(bytes);
+}
+
+std::size_t getMemoryQuota() {
+    return quota.load();
+}
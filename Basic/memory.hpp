@@ -0,0 +1,144 @@
+/*
+ * File: memory.h
+ * --------------
+ * This interface exports the memory accounting used by the
+ * interpreter.  Every allocation owned by the interpreter (the
+ * expression nodes, the program's line table and source text, the
+ * symbol table, the parse cache and the buffers of open files) is
+ * charged to a single per-process account.
+ * If a quota is set, an allocation that would exceed it raises the
+ * BASIC error OUT OF MEMORY instead of growing the process further.
+ * The account also keeps a separate total for each kind of storage,
+ * which is what the STATS command reports.
+ */
+
+#ifndef _memory_h
+#define _memory_h
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+/*
+ * Type: MemoryCategory
+ * --------------------
+ * The kinds of storage that are accounted separately.
+ */
+
+enum MemoryCategory {
+    EXPRESSION_MEMORY,   /* Expression nodes                */
+    STATEMENT_MEMORY,    /* The program's line tables       */
+    SOURCE_MEMORY,       /* The program's source text pool  */
+    SYMBOL_MEMORY,       /* The symbol table                */
+    CACHE_MEMORY,        /* The parse cache                 */
+    FILE_MEMORY,         /* The buffers of open files       */
+    MEMORY_CATEGORIES
+};
+
+/*
+ * Function: chargeMemory
+ * Usage: chargeMemory(bytes, category);
+ * -------------------------------------
+ * Adds bytes to the current usage.  If this would take the usage
+ * above the quota, the usage is left unchanged and the function
+ * raises the error OUT OF MEMORY.
+ */
+
+void chargeMemory(std::size_t bytes, MemoryCategory category);
+
+/*
+ * Function: releaseMemory
+ * Usage: releaseMemory(bytes, category);
+ * --------------------------------------
+ * Subtracts bytes previously charged with chargeMemory.
+ */
+
+void releaseMemory(std::size_t bytes, MemoryCategory category);
+
+/*
+ * Function: getMemoryUsage
+ * Usage: std::size_t bytes = getMemoryUsage();
+ *        std::size_t bytes = getMemoryUsage(category);
+ * ----------------------------------------------------
+ * Returns the number of bytes currently charged to the account,
+ * either in total or for one category.
+ */
+
+std::size_t getMemoryUsage();
+
+std::size_t getMemoryUsage(MemoryCategory category);
+
+/*
+ * Functions: setMemoryQuota, getMemoryQuota
+ * Usage: setMemoryQuota(bytes);
+ *        std::size_t bytes = getMemoryQuota();
+ * ---------------------------------------------
+ * Sets or returns the quota in bytes.  A quota of 0, which is the
+ * default, means that the usage is not limited.
+ */
+
+void setMemoryQuota(std::size_t bytes);
+
+std::size_t getMemoryQuota();
+
+/*
+ * Class: AccountingAllocator
+ * --------------------------
+ * A standard allocator that charges every allocation to a category
+ * of the account before passing it on to std::allocator.  Containers
+ * owned by the interpreter are declared with this allocator.
+ */
+
+template<typename T, MemoryCategory category>
+class AccountingAllocator {
+
+public:
+
+    typedef T value_type;
+
+    template<typename U>
+    struct rebind {
+        typedef AccountingAllocator<U, category> other;
+    };
+
+    AccountingAllocator() = default;
+
+    template<typename U>
+    AccountingAllocator(const AccountingAllocator<U, category> &) {}
+
+    T *allocate(std::size_t n) {
+        chargeMemory(n * sizeof(T), category);
+        try {
+            return std::allocator<T>().allocate(n);
+        } catch (...) {
+            releaseMemory(n * sizeof(T), category);
+            throw;
+        }
+    }
+
+    void deallocate(T *p, std::size_t n) {
+        std::allocator<T>().deallocate(p, n);
+        releaseMemory(n * sizeof(T), category);
+    }
+
+    template<typename U>
+    bool operator==(const AccountingAllocator<U, category> &) const {
+        return true;
+    }
+
+    template<typename U>
+    bool operator!=(const AccountingAllocator<U, category> &) const {
+        return false;
+    }
+
+};
+
+/*
+ * Type: AccountedString
+ * ---------------------
+ * A string whose buffer is charged to the source text category.
+ */
+
+typedef std::basic_string<char, std::char_traits<char>, AccountingAllocator<char, SOURCE_MEMORY>> AccountedString;
+
+#endif
@@ -7,42 +7,84 @@
 #include "parser.hpp"
 
 
+/*
+ * Operator identifiers
+ * --------------------
+ * The parser identifies the operators by small integers, which index
+ * the tables of their names and precedences.  Every operator token is
+ * a single character, so the identifier is found by indexing
+ * OPERATOR_TABLE, which is built at compile time from OPERATOR_NAMES,
+ * with that character.  Together with the lexer, which hands out the
+ * tokens as views into the line, this means that looking at the next
+ * operator never allocates or compares strings.
+ */
+
+enum OperatorId {
+    OP_NONE, OP_EQUALS, OP_PLUS, OP_MINUS, OP_TIMES, OP_DIVIDE, OP_LPAREN, OP_RPAREN
+};
+
+static constexpr const char *OPERATOR_NAMES[] = {"", "=", "+", "-", "*", "/", "(", ")"};
+
+static const int OPERATOR_PRECEDENCE[] = {0, 1, 2, 2, 3, 3, 0, 0};
+
+static const int OPERATOR_COUNT = sizeof OPERATOR_NAMES / sizeof OPERATOR_NAMES[0];
+
+struct OperatorTable {
+    OperatorId id[256];
+};
+
+static constexpr OperatorTable buildOperatorTable() {
+    OperatorTable table = {};
+    for (int op = OP_NONE + 1; op < OPERATOR_COUNT; op++) {
+        table.id[(unsigned char) OPERATOR_NAMES[op][0]] = OperatorId(op);
+    }
+    return table;
+}
+
+static constexpr OperatorTable OPERATOR_TABLE = buildOperatorTable();
+
+static OperatorId operatorId(LexemeKind kind, std::string_view token) {
+    if (kind != LEX_OPERATOR) return OP_NONE;
+    return OPERATOR_TABLE.id[(unsigned char) token[0]];
+}
+
 /*
  * Implementation notes: parseExp
  * ------------------------------
  * This code just reads an expression and then checks for extra tokens.
  */
 
-Expression *parseExp(TokenScanner &scanner) {
-    Expression *exp = readE(scanner);
-    if (scanner.hasMoreTokens()) {
-        error("parseExp: Found extra token: " + scanner.nextToken());
+std::unique_ptr<Expression> parseExp(TokenArray &tokens) {
+    std::unique_ptr<Expression> exp = readE(tokens);
+    if (tokens.hasMoreTokens()) {
+        error("parseExp: Found extra token: " + std::string(tokens.nextToken()));
     }
     return exp;
 }
 
 /*
  * Implementation notes: readE
- * Usage: exp = readE(scanner, prec);
- * ----------------------------------
- * This version of readE uses precedence to resolve the ambiguity in
- * the grammar.  At each recursive level, the parser reads operators and
- * subexpressions until it finds an operator whose precedence is greater
- * than the prevailing one.  When a higher-precedence operator is found,
- * readE calls itself recursively to read in that subexpression as a unit.
+ * Usage: exp = readE(tokens, prec);
+ * ---------------------------------
+ * This version of readE is a precedence-climbing (Pratt) parser.  After
+ * reading a term, it looks at the next token without consuming it; as
+ * long as that token is an operator that binds more tightly than prec,
+ * the operator is consumed and its right operand is read by a recursive
+ * call at the operator's own precedence, which makes operators of equal
+ * precedence group to the left.  The token that stops the loop stays
+ * in the array for the caller.
  */
 
-Expression *readE(TokenScanner &scanner, int prec) {
-    Expression *exp = readT(scanner);
-    std::string token;
+std::unique_ptr<Expression> readE(TokenArray &tokens, int prec) {
+    std::unique_ptr<Expression> exp = readT(tokens);
     while (true) {
-        token = scanner.nextToken();
-        int newPrec = precedence(token);
+        OperatorId op = operatorId(tokens.peekKind(), tokens.peekToken());
+        int newPrec = OPERATOR_PRECEDENCE[op];
         if (newPrec <= prec) break;
-        Expression *rhs = readE(scanner, newPrec);
-        exp = new CompoundExp(token, exp, rhs);
+        tokens.nextToken();
+        std::unique_ptr<Expression> rhs = readE(tokens, newPrec);
+        exp = std::make_unique<CompoundExp>(OPERATOR_NAMES[op], std::move(exp), std::move(rhs));
     }
-    scanner.saveToken(token);
     return exp;
 }
 
@@ -50,23 +92,179 @@ Expression *readE(TokenScanner &scanner, int prec) {
  * Implementation notes: readT
  * ---------------------------
  * This function scans a term, which is either an integer, an identifier,
- * or a parenthesized subexpression.
+ * or a parenthesized subexpression.  A unary minus is read as zero minus
+ * the whole expression that follows it.
  */
 
-Expression *readT(TokenScanner &scanner) {
-    std::string token = scanner.nextToken();
-    TokenType type = scanner.getTokenType(token);
-    if (type == WORD) return new IdentifierExp(token);
-    if (type == NUMBER) return new ConstantExp(stringToInteger(token));
-    if (token == "-") return new CompoundExp(token, new ConstantExp(0), readE(scanner));
-    if (token != "(") error("Illegal term in expression");
-    Expression *exp = readE(scanner);
-    if (scanner.nextToken() != ")") {
+std::unique_ptr<Expression> readT(TokenArray &tokens) {
+    LexemeKind kind = tokens.peekKind();
+    std::string_view token = tokens.nextToken();
+    if (kind == LEX_WORD) return std::make_unique<IdentifierExp>(std::string(token));
+    if (kind == LEX_NUMBER) return std::make_unique<ConstantExp>(stringToInteger(token));
+    OperatorId op = operatorId(kind, token);
+    if (op == OP_MINUS) return std::make_unique<CompoundExp>("-", std::make_unique<ConstantExp>(0), readE(tokens));
+    if (op != OP_LPAREN) error("Illegal term in expression");
+    std::unique_ptr<Expression> exp = readE(tokens);
+    if (tokens.nextToken() != ")") {
         error("Unbalanced parentheses in expression");
     }
     return exp;
 }
 
+/*
+ * Implementation notes: checkE, checkT
+ * ------------------------------------
+ * These functions follow readE and readT step by step.  Numbers are
+ * still converted, because stringToInteger is what rejects a number
+ * that is malformed or too large.
+ */
+
+ExpressionType checkE(TokenArray &tokens, int prec) {
+    ExpressionType type = checkT(tokens);
+    while (true) {
+        OperatorId op = operatorId(tokens.peekKind(), tokens.peekToken());
+        int newPrec = OPERATOR_PRECEDENCE[op];
+        if (newPrec <= prec) break;
+        tokens.nextToken();
+        checkE(tokens, newPrec);
+        type = COMPOUND;
+    }
+    return type;
+}
+
+ExpressionType checkT(TokenArray &tokens) {
+    LexemeKind kind = tokens.peekKind();
+    std::string_view token = tokens.nextToken();
+    if (kind == LEX_WORD) return IDENTIFIER;
+    if (kind == LEX_NUMBER) {
+        stringToInteger(token);
+        return CONSTANT;
+    }
+    OperatorId op = operatorId(kind, token);
+    if (op == OP_MINUS) {
+        checkE(tokens);
+        return COMPOUND;
+    }
+    if (op != OP_LPAREN) error("Illegal term in expression");
+    ExpressionType type = checkE(tokens);
+    if (tokens.nextToken() != ")") {
+        error("Unbalanced parentheses in expression");
+    }
+    return type;
+}
+
+/*
+ * Implementation notes: DirectEvaluator
+ * -------------------------------------
+ * evalE and evalT follow readE and readT step by step, and each
+ * operator is applied as soon as its right operand has been read,
+ * which is the order in which eval visits the nodes of the tree.  Once
+ * an error has been found, the rest of the expression is only read.
+ * The one operation eval does not perform in reading order is an
+ * assignment whose left operand is not a variable: eval reports the
+ * error without evaluating that operand at all, so evalE undoes the
+ * assignments and the error recorded while the operand was read.
+ */
+
+int DirectEvaluator::evaluate(TokenArray &tokens, EvalState &state, int prec) {
+    this->state = &state;
+    assignments.clear();
+    failure = nullptr;
+    return valueOf(evalE(tokens, prec));
+}
+
+void DirectEvaluator::commit(EvalState &state) {
+    for (const Assignment &assignment: assignments) {
+        state.setValue(assignment.name, assignment.value);
+    }
+    if (failure != nullptr) error(failure);
+}
+
+DirectEvaluator::Operand DirectEvaluator::evalE(TokenArray &tokens, int prec) {
+    std::size_t firstAssignment = assignments.size();
+    const char *earlierFailure = failure;
+    Operand lhs = evalT(tokens);
+    while (true) {
+        OperatorId op = operatorId(tokens.peekKind(), tokens.peekToken());
+        int newPrec = OPERATOR_PRECEDENCE[op];
+        if (newPrec <= prec) break;
+        tokens.nextToken();
+        if (op == OP_EQUALS) {
+            if (lhs.name.empty()) {
+                if (earlierFailure == nullptr) {
+                    assignments.resize(firstAssignment);
+                    failure = "Illegal variable in assignment";
+                }
+            } else if (lhs.name == "LET") {
+                fail("SYNTAX ERROR");
+            }
+            int value = valueOf(evalE(tokens, newPrec));
+            if (failure == nullptr) assignments.push_back({lhs.name, value});
+            lhs = {value, std::string_view()};
+            continue;
+        }
+        int left = valueOf(lhs);
+        int right = valueOf(evalE(tokens, newPrec));
+        lhs = {0, std::string_view()};
+        if (failure != nullptr) continue;
+        switch (op) {
+            case OP_PLUS: lhs.value = left + right; break;
+            case OP_MINUS: lhs.value = left - right; break;
+            case OP_TIMES: lhs.value = left * right; break;
+            default:
+                if (right == 0) {
+                    fail("DIVIDE BY ZERO");
+                } else {
+                    lhs.value = left / right;
+                }
+                break;
+        }
+    }
+    return lhs;
+}
+
+DirectEvaluator::Operand DirectEvaluator::evalT(TokenArray &tokens) {
+    LexemeKind kind = tokens.peekKind();
+    std::string_view token = tokens.nextToken();
+    if (kind == LEX_WORD) return {0, token};
+    if (kind == LEX_NUMBER) return {stringToInteger(token), std::string_view()};
+    OperatorId op = operatorId(kind, token);
+    if (op == OP_MINUS) {
+        int value = valueOf(evalE(tokens, 0));
+        return {failure == nullptr ? 0 - value : 0, std::string_view()};
+    }
+    if (op != OP_LPAREN) error("Illegal term in expression");
+    Operand operand = evalE(tokens, 0);
+    if (tokens.nextToken() != ")") {
+        error("Unbalanced parentheses in expression");
+    }
+    return operand;
+}
+
+/*
+ * Implementation notes: valueOf
+ * -----------------------------
+ * A variable assigned earlier in the expression has the value of its
+ * most recent recorded assignment, as it would after eval had stored
+ * it.
+ */
+
+int DirectEvaluator::valueOf(const Operand &operand) {
+    if (failure != nullptr || operand.name.empty()) return operand.value;
+    for (auto iter = assignments.rbegin(); iter != assignments.rend(); ++iter) {
+        if (iter->name == operand.name) return iter->value;
+    }
+    if (!state->isDefined(operand.name)) {
+        fail("VARIABLE NOT DEFINED");
+        return 0;
+    }
+    return state->getValue(operand.name);
+}
+
+void DirectEvaluator::fail(const char *message) {
+    if (failure == nullptr) failure = message;
+}
+
 /*
  * Implementation notes: precedence
  * --------------------------------
@@ -74,7 +272,7 @@ Expression *readT(TokenScanner &scanner) {
  * and returns the appropriate precedence value.
  */
 
-int precedence(std::string token) {
+int precedence(std::string_view token) {
     if (token == "=") return 1;
     if (token == "+" || token == "-") return 2;
     if (token == "*" || token == "/") return 3;
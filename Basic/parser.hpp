@@ -7,46 +7,151 @@
 #ifndef _parser_h
 #define _parser_h
 
+#include <memory>
 #include <string>
+#include <string_view>
 #include <iostream>
+#include <vector>
+#include "evalstate.hpp"
 #include "exp.hpp"
 
-#include "Utils/tokenScanner.hpp"
+#include "Utils/lexer.hpp"
 #include "Utils/error.hpp"
 #include "Utils/strlib.hpp"
 
 
+/*
+ * Ownership of the parsed trees
+ * -----------------------------
+ * Every function below returns its expression through a unique_ptr,
+ * and every partial tree is held by a unique_ptr while the rest of
+ * the expression is read.  If an error is raised halfway through an
+ * expression, the nodes built so far are freed as the exception
+ * unwinds.
+ */
+
 /*
  * Function: parseExp
- * Usage: Expression *exp = parseExp(scanner);
- * -------------------------------------------
- * Parses an expression by reading tokens from the scanner, which must
- * be provided by the client.  The scanner should be set to ignore
- * whitespace and to scan numbers.
+ * Usage: std::unique_ptr<Expression> exp = parseExp(tokens);
+ * ----------------------------------------------------------
+ * Parses an expression by reading tokens from the token array, which
+ * must be provided by the client, and checks that no tokens are left.
  */
 
-Expression *parseExp(TokenScanner &scanner);
+std::unique_ptr<Expression> parseExp(TokenArray &tokens);
 
 /*
  * Function: readE
- * Usage: Expression *exp = readE(scanner, prec);
- * ----------------------------------------------
- * Returns the next expression from the scanner involving only operators
- * whose precedence is at least prec.  The prec argument is optional and
- * defaults to 0, which means that the function reads the entire expression.
+ * Usage: std::unique_ptr<Expression> exp = readE(tokens, prec);
+ * -------------------------------------------------------------
+ * Returns the next expression from the token array involving only
+ * operators whose precedence is greater than prec.  The prec argument
+ * is optional and defaults to 0, which means that the function reads
+ * the entire expression.  The token that ends the expression is left
+ * in the array.
  */
 
-Expression *readE(TokenScanner &scanner, int prec = 0);
+std::unique_ptr<Expression> readE(TokenArray &tokens, int prec = 0);
 
 /*
  * Function: readT
- * Usage: Expression *exp = readT(scanner);
- * ----------------------------------------
+ * Usage: std::unique_ptr<Expression> exp = readT(tokens);
+ * -------------------------------------------------------
  * Returns the next individual term, which is either a constant, an
  * identifier, or a parenthesized subexpression.
  */
 
-Expression *readT(TokenScanner &scanner);
+std::unique_ptr<Expression> readT(TokenArray &tokens);
+
+/*
+ * Functions: checkE, checkT
+ * Usage: ExpressionType type = checkE(tokens, prec);
+ *        ExpressionType type = checkT(tokens);
+ * --------------------------------------------------
+ * Read the same tokens as readE and readT and raise the same errors,
+ * but only check the syntax of the expression without building it.
+ * The result is the type of the node that readE or readT would have
+ * returned.
+ */
+
+ExpressionType checkE(TokenArray &tokens, int prec = 0);
+
+ExpressionType checkT(TokenArray &tokens);
+
+/*
+ * Class: DirectEvaluator
+ * ----------------------
+ * Computes the value of an expression while reading it, without
+ * building a tree, for LET and PRINT commands that are executed at
+ * once.  The outcome is the same as reading the expression with readE
+ * and then calling eval on it.  Syntax errors are raised while the
+ * expression is read, before any variable changes.  Errors found by
+ * the evaluation, and the assignments made before them, are held back
+ * until commit, which the caller only calls once it has checked the
+ * rest of the line.  An evaluator can be reused for any number of
+ * expressions, and once its storage has grown to fit the assignments
+ * of a line it evaluates without allocating memory.
+ */
+
+class DirectEvaluator {
+
+public:
+
+/*
+ * Method: evaluate
+ * Usage: int value = evaluator.evaluate(tokens, state, prec);
+ * -----------------------------------------------------------
+ * Reads the same tokens as readE(tokens, prec), raising the same
+ * syntax errors, and returns the value of the expression.  Variables
+ * are read from state, but assignments are only recorded.  The value
+ * is meaningless if commit raises an error.  The recorded names point
+ * into the line of the token array, which must not change before
+ * commit is called.
+ */
+
+    int evaluate(TokenArray &tokens, EvalState &state, int prec = 0);
+
+/*
+ * Method: commit
+ * Usage: evaluator.commit(state);
+ * -------------------------------
+ * Stores the assignments recorded by the last call to evaluate in
+ * state and then raises the error that stopped the evaluation, if
+ * there was one.
+ */
+
+    void commit(EvalState &state);
+
+private:
+
+/*
+ * Type: Operand
+ * -------------
+ * The value of a subexpression.  A variable is not looked up until
+ * its value is needed, because the left operand of an assignment is
+ * never evaluated; until then, name holds the name of the variable.
+ */
+
+    struct Operand {
+        int value;
+        std::string_view name;
+    };
+
+    struct Assignment {
+        std::string_view name;
+        int value;
+    };
+
+    Operand evalE(TokenArray &tokens, int prec);
+    Operand evalT(TokenArray &tokens);
+    int valueOf(const Operand &operand);
+    void fail(const char *message);
+
+    EvalState *state = nullptr;
+    std::vector<Assignment> assignments;
+    const char *failure = nullptr;      /* The error held back for commit */
+
+};
 
 /*
  * Function: precedence
@@ -56,6 +161,6 @@ Expression *readT(TokenScanner &scanner);
  * is not an operator, precedence returns 0.
  */
 
-int precedence(std::string token);
+int precedence(std::string_view token);
 
 #endif
@@ -1,15 +1,26 @@
 /*
  * File: program.cpp
  * -----------------
- * This file is a stub implementation of the program.h interface
- * in which none of the methods do anything beyond returning a
- * value of the correct type.  Your job is to fill in the bodies
- * of each of these methods with an implementation that satisfies
- * the performance guarantees specified in the assignment.
+ * This file implements the program.h interface.  The lines are
+ * kept sorted by line number in a table of chunks; lookups use
+ * binary search and RUN walks the table with a cursor.  The
+ * source text lives in one append-only pool.
  */
 
+#include <algorithm>
+#include <climits>
+#include <iterator>
 #include "program.hpp"
 
+/*
+ * Constant: CHUNK_LINES
+ * ---------------------
+ * The number of lines in a chunk of the line table.  Lines added after
+ * the last one fill chunks of this size, and a chunk that grows to
+ * twice this size is split in two.
+ */
+
+static const std::size_t CHUNK_LINES = 256;
 
 
 Program::Program() = default;
@@ -17,103 +28,434 @@ Program::Program() = default;
 Program::~Program() = default;
 
 void Program::clear() {
-    // Replace this stub with your own code
-    //todo
-    for (auto iter = line_list.begin(); iter != line_list.end(); iter++) {
-        delete parsed_line[*iter];
+    if (!lines.empty()) {
+        try {
+            retired.push_back(std::move(lines));
+        } catch (...) {
+            /* No room to set the table aside: free it right away */
+        }
+        lines = LineTable();
     }
-    for (auto iter = temporary_line.begin(); iter != temporary_line.end(); iter++) {
-        delete *iter;
+    lineCount = 0;
+    AccountedString().swap(pool);
+    garbage = 0;
+    cursor = {0, 0};
+    jumped = false;
+}
+
+/*
+ * Implementation notes: reclaim
+ * -----------------------------
+ * Lines are destroyed from the back of the most recently retired
+ * table, and a chunk or a table is released once it is empty.
+ */
+
+void Program::reclaim(int budget) {
+    while (budget != 0 && !retired.empty()) {
+        LineTable &table = retired.back();
+        if (table.empty()) {
+            retired.pop_back();
+            continue;
+        }
+        if (table.back().empty()) {
+            table.pop_back();
+            continue;
+        }
+        table.back().pop_back();
+        budget--;
     }
-    parsed_line.clear();
-    temporary_line.clear();
-    line_list.clear();
-    source_line.clear();
 }
 
-void Program::addSourceLine(int lineNumber, const std::string &line) {
-    // Replace this stub with your own code
-    //todo
-    line_list.insert(lineNumber);
-    source_line[lineNumber] = line;
+/*
+ * Implementation notes: addSourceLine
+ * -----------------------------------
+ * The new line is built completely before the table is touched, so
+ * that an OUT OF MEMORY error leaves the program as it was.
+ */
+
+void Program::addSourceLine(int lineNumber, std::string_view line, Statement stmt) {
+    ProgramLine newLine{lineNumber, 0, 0, true, std::move(stmt)};
+    storeSource(newLine, line);
+    insertLine(newLine);
+}
+
+void Program::addUnparsedLine(int lineNumber, std::string_view line) {
+    ProgramLine newLine{lineNumber, int(line.size()), pool.size(), false, RemStmt()};
+    pool.append(line.data(), line.size());
+    insertLine(newLine);
+}
+
+/*
+ * Implementation notes: mergeLines
+ * --------------------------------
+ * Everything that allocates is done first: the text of the new lines
+ * goes into the pool and the chunks of the result are reserved.  Only
+ * then are the lines moved, which cannot fail.  If the edits all come
+ * after the last line, the new chunks are simply appended to the
+ * table; otherwise the old lines and the new ones are merged into a
+ * new table, which replaces the old one.
+ */
+
+void Program::mergeLines(std::vector<LineEdit> &edits) {
+    if (edits.empty()) return;
+    LineChunk added;
+    std::size_t count = lineCount;
+    try {
+        added.reserve(edits.size());
+        for (LineEdit &edit: edits) {
+            bool exists = findLine(edit.lineNumber) != nullptr;
+            if (edit.remove) {
+                if (exists) count--;
+                continue;
+            }
+            if (!exists) count++;
+            ProgramLine line{edit.lineNumber, 0, 0, edit.parsed, std::move(edit.stmt)};
+            if (edit.parsed) {
+                storeSource(line, edit.text);
+            } else {
+                pool.append(edit.text.data(), edit.text.size());
+                line.length = edit.text.size();
+                line.offset = pool.size() - edit.text.size();
+            }
+            added.push_back(std::move(line));
+        }
+    } catch (...) {
+        for (const ProgramLine &line: added) {
+            releaseSource(line);
+        }
+        throw;
+    }
+    bool append = lines.empty() || edits.front().lineNumber > lines.back().back().lineNumber;
+    LineTable merged;
+    try {
+        merged = allocateChunks(append ? added.size() : count);
+        if (append) lines.reserve(lines.size() + merged.size());
+    } catch (...) {
+        for (const ProgramLine &line: added) {
+            releaseSource(line);
+        }
+        throw;
+    }
+    std::size_t chunk = 0;
+    auto push = [&merged, &chunk](ProgramLine &line) {
+        if (merged[chunk].size() == CHUNK_LINES) chunk++;
+        merged[chunk].push_back(std::move(line));
+    };
+    std::size_t next = 0;
+    if (!append) {
+        std::size_t edit = 0;
+        for (LineChunk &old: lines) {
+            for (ProgramLine &line: old) {
+                while (edit < edits.size() && edits[edit].lineNumber < line.lineNumber) {
+                    if (!edits[edit].remove) push(added[next++]);
+                    edit++;
+                }
+                if (edit < edits.size() && edits[edit].lineNumber == line.lineNumber) {
+                    releaseSource(line);
+                    if (!edits[edit].remove) push(added[next++]);
+                    edit++;
+                    continue;
+                }
+                push(line);
+            }
+        }
+    }
+    while (next < added.size()) {
+        push(added[next++]);
+    }
+    if (append) {
+        for (LineChunk &newChunk: merged) {
+            lines.push_back(std::move(newChunk));
+        }
+    } else {
+        lines.swap(merged);
+    }
+    lineCount = count;
+    compact();
+}
+
+Program::LineTable Program::allocateChunks(std::size_t count) {
+    LineTable table;
+    table.reserve((count + CHUNK_LINES - 1) / CHUNK_LINES);
+    for (std::size_t left = count; left > 0; left -= std::min(left, CHUNK_LINES)) {
+        table.emplace_back();
+        table.back().reserve(std::min(left, CHUNK_LINES));
+    }
+    return table;
+}
+
+void Program::setLineParser(LineParser parser) {
+    lineParser = parser;
+}
+
+/*
+ * Implementation notes: insertLine
+ * --------------------------------
+ * A line after the last one is appended to the last chunk, or starts
+ * a new chunk if that one is full, so a program entered in order ends
+ * up in full chunks.  Any other line is inserted into the chunk that
+ * holds its position.  Moving a ProgramLine cannot throw, so if there
+ * is no room for the line the table is left unchanged.
+ */
+
+void Program::insertLine(ProgramLine &newLine) {
+    Position pos = find(newLine.lineNumber);
+    if (pos.chunk < lines.size()) {
+        ProgramLine &line = lines[pos.chunk][pos.index];
+        if (line.lineNumber == newLine.lineNumber) {
+            releaseSource(line);
+            line = std::move(newLine);
+            compact();
+            return;
+        }
+    }
+    try {
+        if (pos.chunk == lines.size()) {
+            if (lines.empty() || lines.back().size() >= CHUNK_LINES) {
+                lines.emplace_back();
+            }
+            pos = {lines.size() - 1, lines.back().size()};
+        }
+        LineChunk &chunk = lines[pos.chunk];
+        chunk.insert(chunk.begin() + pos.index, std::move(newLine));
+    } catch (...) {
+        if (!lines.empty() && lines.back().empty()) lines.pop_back();
+        releaseSource(newLine);
+        throw;
+    }
+    lineCount++;
+    if (lines[pos.chunk].size() >= 2 * CHUNK_LINES) splitChunk(pos.chunk);
+}
+
+void Program::splitChunk(std::size_t chunk) {
+    try {
+        lines.reserve(lines.size() + 1);
+        lines.insert(lines.begin() + chunk + 1, LineChunk());
+        LineChunk &lower = lines[chunk];
+        auto half = lower.begin() + lower.size() / 2;
+        lines[chunk + 1].assign(std::make_move_iterator(half), std::make_move_iterator(lower.end()));
+        lower.erase(half, lower.end());
+    } catch (...) {
+        if (chunk + 1 < lines.size() && lines[chunk + 1].empty()) {
+            lines.erase(lines.begin() + chunk + 1);
+        }
+    }
 }
 
 void Program::removeSourceLine(int lineNumber) {
-    // Replace this stub with your own code
-    //todo
-    auto iter_lineNumber = line_list.find(lineNumber);
-    if (iter_lineNumber == line_list.end()) {
+    Position pos = find(lineNumber);
+    if (pos.chunk == lines.size() || lines[pos.chunk][pos.index].lineNumber != lineNumber) {
         return;
     }
-    line_list.erase(iter_lineNumber);
-    source_line.erase(lineNumber);
-    delete parsed_line[lineNumber];
-    parsed_line.erase(lineNumber);
+    LineChunk &chunk = lines[pos.chunk];
+    releaseSource(chunk[pos.index]);
+    chunk.erase(chunk.begin() + pos.index);
+    if (chunk.empty()) lines.erase(lines.begin() + pos.chunk);
+    lineCount--;
+    compact();
 }
 
 std::string Program::getSourceLine(int lineNumber) {
-    // Replace this stub with your own code
-    //todo
-    if (line_list.find(lineNumber) == line_list.end()) {
+    ProgramLine *line = findLine(lineNumber);
+    if (line == nullptr) {
         return "";
     }
-    return source_line[lineNumber];
+    if (line->length < 0) {
+        return canonicalSource(*line);
+    }
+    return std::string(pool.data() + line->offset, line->length);
 }
 
-void Program::setParsedStatement(int lineNumber, Statement *stmt) {
-    // Replace this stub with your own code
-    //todo
-    auto iter_lineNumber = line_list.find(lineNumber);
-    if (iter_lineNumber == line_list.end()) {
-        error("Compiled Error");
-        return;
-    }
-    delete parsed_line[lineNumber];
-    parsed_line[lineNumber] = stmt;
+int Program::getLineCount() const {
+    return lineCount;
 }
 
-//void Program::removeSourceLine(int lineNumber) {
+void Program::writeSource(OutputBuffer &out) const {
+    for (const LineChunk &chunk: lines) {
+        for (const ProgramLine &line: chunk) {
+            if (line.length < 0) {
+                out << canonicalSource(line) << '\n';
+                continue;
+            }
+            out << std::string_view(pool.data() + line.offset, line.length) << '\n';
+        }
+    }
+}
 
 Statement *Program::getParsedStatement(int lineNumber) {
-    // Replace this stub with your own code
-    //todo
-    auto iter_lineNumber = line_list.find(lineNumber);
-    if (iter_lineNumber == line_list.end()) {
+    ProgramLine *line = findLine(lineNumber);
+    if (line == nullptr) {
         return nullptr;
     }
-    return parsed_line[lineNumber];
+    if (!line->parsed) {
+        parseLine(*line);
+    }
+    return &line->stmt;
 }
 
 int Program::getFirstLineNumber() {
-    // Replace this stub with your own code
-    //todo
-    if (line_list.empty()) {
+    if (lines.empty()) {
         return -1;
     }
-    return *line_list.begin();
+    return lines.front().front().lineNumber;
 }
 
-int Program::getNextLineNumber() {
-    // Replace this stub with your own code
-    //todo
-    auto iter_lineNumber = line_list.upper_bound(nowLineNumber);
-    if (iter_lineNumber == line_list.end() || nowLineNumber == -1) {
+int Program::getNextLineNumber(int lineNumber) {
+    if (lineNumber == INT_MAX) {
         return -1;
     }
-    return *iter_lineNumber;
+    Position pos = find(lineNumber + 1);
+    if (pos.chunk == lines.size()) {
+        return -1;
+    }
+    return lines[pos.chunk][pos.index].lineNumber;
 }
 
-//more func to add
-//todo
+void Program::start() {
+    cursor = {0, 0};
+    jumped = false;
+}
 
-int Program::getNowLineNumber() const {
-    return nowLineNumber;
+void Program::advance() {
+    if (jumped) {
+        jumped = false;
+        return;
+    }
+    if (cursor.chunk == lines.size()) {
+        return;
+    }
+    if (++cursor.index == lines[cursor.chunk].size()) {
+        cursor.chunk++;
+        cursor.index = 0;
+    }
+}
+
+void Program::stop() {
+    cursor = {lines.size(), 0};
+    jumped = false;
+}
+
+bool Program::jumpTo(int lineNumber) {
+    Position pos = find(lineNumber);
+    if (pos.chunk == lines.size() || lines[pos.chunk][pos.index].lineNumber != lineNumber) {
+        return false;
+    }
+    cursor = pos;
+    jumped = true;
+    return true;
+}
+
+Statement *Program::getCurrentStatement() {
+    if (cursor.chunk >= lines.size()) {
+        return nullptr;
+    }
+    ProgramLine &line = lines[cursor.chunk][cursor.index];
+    if (!line.parsed) {
+        parseLine(line);
+    }
+    return &line.stmt;
+}
+
+/*
+ * Implementation notes: parseLine
+ * -------------------------------
+ * Once the line is parsed, its text is dropped if it turns out to be
+ * canonical, just as if the line had been added by addSourceLine.
+ */
+
+void Program::parseLine(ProgramLine &line) {
+    lineParser(std::string_view(pool.data() + line.offset, line.length), line.stmt);
+    line.parsed = true;
+    std::string_view text(pool.data() + line.offset, line.length);
+    if (text == canonicalSource(line)) {
+        releaseSource(line);
+        line.offset = 0;
+        line.length = -1;
+    }
+}
+
+/*
+ * Implementation notes: storeSource
+ * ---------------------------------
+ * The text is compared byte for byte with the canonical form, so
+ * LIST prints exactly what was entered whether or not it is kept.
+ */
+
+void Program::storeSource(ProgramLine &line, std::string_view text) {
+    if (text == canonicalSource(line)) {
+        line.offset = 0;
+        line.length = -1;
+        return;
+    }
+    pool.append(text.data(), text.size());
+    line.offset = pool.size() - text.size();
+    line.length = text.size();
+}
+
+std::string Program::canonicalSource(const ProgramLine &line) const {
+    return integerToString(line.lineNumber) + ' ' + statementToString(line.stmt);
 }
 
-void Program::changeNowLineNumber(int lineNumber) {
-    nowLineNumber = lineNumber;
+void Program::releaseSource(const ProgramLine &line) {
+    if (line.length > 0) {
+        garbage += line.length;
+    }
 }
 
-void Program::addTemporaryLine(Statement *Stmt) {
-    temporary_line.push_back(Stmt);
+/*
+ * Implementation notes: compact
+ * -----------------------------
+ * The pool is only rebuilt when the garbage is both larger than the
+ * live text and larger than a fixed threshold.  Every rebuild is paid
+ * for by the edits that produced the garbage, so the amortized cost
+ * of an edit stays constant while the pool never grows beyond about
+ * twice the live text.  If the new pool does not fit in the memory
+ * quota, the old one is simply kept.
+ */
+
+void Program::compact() {
+    if (garbage < 4096 || garbage < pool.size() - garbage) {
+        return;
+    }
+    AccountedString newPool;
+    try {
+        newPool.reserve(pool.size() - garbage);
+    } catch (ErrorException &) {
+        return;
+    }
+    for (LineChunk &chunk: lines) {
+        for (ProgramLine &line: chunk) {
+            if (line.length < 0) {
+                continue;
+            }
+            std::size_t offset = newPool.size();
+            newPool.append(pool, line.offset, line.length);
+            line.offset = offset;
+        }
+    }
+    pool.swap(newPool);
+    garbage = 0;
+}
+
+Program::Position Program::find(int lineNumber) const {
+    auto chunk = std::lower_bound(lines.begin(), lines.end(), lineNumber,
+                                  [](const LineChunk &chunk, int number) {
+                                      return chunk.back().lineNumber < number;
+                                  });
+    if (chunk == lines.end()) {
+        return {lines.size(), 0};
+    }
+    auto line = std::lower_bound(chunk->begin(), chunk->end(), lineNumber,
+                                 [](const ProgramLine &line, int number) {
+                                     return line.lineNumber < number;
+                                 });
+    return {std::size_t(chunk - lines.begin()), std::size_t(line - chunk->begin())};
+}
+
+Program::ProgramLine *Program::findLine(int lineNumber) {
+    Position pos = find(lineNumber);
+    if (pos.chunk == lines.size() || lines[pos.chunk][pos.index].lineNumber != lineNumber) {
+        return nullptr;
+    }
+    return &lines[pos.chunk][pos.index];
 }
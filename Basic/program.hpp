@@ -8,14 +8,13 @@
 #ifndef _program_h
 #define _program_h
 
+#include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <set>
-#include <unordered_map>
+#include "memory.hpp"
 #include "statement.hpp"
-
-
-class Statement;
+#include "Utils/outputBuffer.hpp"
 
 /*
  * This class stores the lines in a BASIC program.  Each line
@@ -27,7 +26,28 @@ class Statement;
  *    line number) that was entered by the user.
  *
  * 2. The parsed representation of that statement, which is a
- *    pointer to a Statement.
+ *    Statement value stored inline in the line table.
+ *
+ * The lines are kept sorted by line number in a table of chunks,
+ * each of which is a vector of a few hundred lines.  RUN and LIST
+ * walk memory in order, a line is found by binary search over the
+ * chunks and then within one, and adding or removing a line only
+ * shifts the lines of its own chunk.  The program also keeps a
+ * cursor into this table, which is the line currently being
+ * executed by RUN.
+ *
+ * The source text of all lines is kept in a single character pool.
+ * Each entry of the line table only records the offset and length
+ * of its text in the pool.  Most lines are entered exactly as the
+ * canonical printer would print them; those keep no text at all
+ * and LIST prints them again from the statement.  Replacing or
+ * removing a line leaves its old text behind as garbage, and the
+ * pool is compacted once the garbage outweighs the live text.
+ *
+ * A line can also be stored without its parsed representation, in
+ * which case only the text is kept.  Such a line is parsed the first
+ * time its statement is requested, by the function registered with
+ * setLineParser, and the statement is kept from then on.
  */
 
 class Program {
@@ -56,23 +76,94 @@ public:
  * Method: clear
  * Usage: program.clear();
  * -----------------------
- * Removes all lines from the program.
+ * Removes all lines from the program in constant time.  The line
+ * table is set aside as a whole and its statements are freed later
+ * by reclaim, so the program is ready for new lines immediately.
  */
 
     void clear();
 
+/*
+ * Method: reclaim
+ * Usage: program.reclaim(budget);
+ * -------------------------------
+ * Frees the statements of at most budget lines set aside by clear.
+ * A negative budget frees all of them.
+ */
+
+    void reclaim(int budget);
+
 /*
  * Method: addSourceLine
- * Usage: program.addSourceLine(lineNumber, line);
- * -----------------------------------------------
- * Adds a source line to the program with the specified line number.
- * If that line already exists, the text of the line replaces
- * the text of any existing line and the parsed representation
- * (if any) is deleted.  If the line is new, it is added to the
- * program in the correct sequence.
+ * Usage: program.addSourceLine(lineNumber, line, std::move(stmt));
+ * ----------------------------------------------------------------
+ * Adds a source line and its parsed representation to the program
+ * with the specified line number.  If that line already exists, the
+ * new line replaces the text and the parsed representation of the
+ * existing line.  If the line is new, it is added to the program in
+ * the correct sequence.  The text is only kept if it differs from
+ * the canonical form printed from the statement.
  */
 
-    void addSourceLine(int lineNumber, const std::string& line);
+    void addSourceLine(int lineNumber, std::string_view line, Statement stmt);
+
+/*
+ * Method: addUnparsedLine
+ * Usage: program.addUnparsedLine(lineNumber, line);
+ * -------------------------------------------------
+ * Adds a source line like addSourceLine, but without parsing it.  The
+ * line must have been checked to be a valid statement, since it is
+ * parsed later without any chance to reject it.
+ */
+
+    void addUnparsedLine(int lineNumber, std::string_view line);
+
+/*
+ * Type: LineEdit
+ * --------------
+ * One change applied by mergeLines.  Unless remove is set, the line
+ * with the given number is added or replaced with text, together with
+ * stmt if parsed is set or unparsed as by addUnparsedLine otherwise.
+ */
+
+    struct LineEdit {
+        int lineNumber;
+        std::string_view text;
+        bool remove;
+        bool parsed;
+        Statement stmt;
+    };
+
+/*
+ * Method: mergeLines
+ * Usage: program.mergeLines(edits);
+ * ---------------------------------
+ * Applies edits that are sorted by line number, at most one for each
+ * number, in a single pass over the line table.  The result is the
+ * same as applying them one by one with addSourceLine, addUnparsedLine
+ * and removeSourceLine, and the statements are moved out of edits.
+ * If there is not enough memory, none of the edits is applied.
+ */
+
+    void mergeLines(std::vector<LineEdit> &edits);
+
+/*
+ * Type: LineParser
+ * ----------------
+ * A function that parses the complete text of a valid program line,
+ * including its line number, into a statement.
+ */
+
+    typedef void (*LineParser)(std::string_view line, Statement &stmt);
+
+/*
+ * Method: setLineParser
+ * Usage: program.setLineParser(parser);
+ * -------------------------------------
+ * Sets the function used to parse the lines added by addUnparsedLine.
+ */
+
+    void setLineParser(LineParser parser);
 
 /*
  * Method: removeSourceLine
@@ -97,31 +188,39 @@ public:
     std::string getSourceLine(int lineNumber);
 
 /*
- * Method: setParsedStatement
- * Usage: program.setParsedStatement(lineNumber, stmt);
- * ----------------------------------------------------
- * Adds the parsed representation of the statement to the statement
- * at the specified line number.  If no such line exists, this
- * method raises an error.  If a previous parsed representation
- * exists, the memory for that statement is reclaimed.
+ * Method: getLineCount
+ * Usage: int count = program.getLineCount();
+ * ------------------------------------------
+ * Returns the number of lines in the program.
+ */
+
+    int getLineCount() const;
+
+/*
+ * Method: writeSource
+ * Usage: program.writeSource(standardOutput());
+ * --------------------------------------------
+ * Writes every source line of the program to the buffer, in order
+ * of line number and each followed by a newline.  This is the
+ * implementation of LIST and reads straight from the text pool.
  */
 
-    void setParsedStatement(int lineNumber, Statement *stmt);
+    void writeSource(OutputBuffer &out) const;
 
 /*
  * Method: getParsedStatement
  * Usage: Statement *stmt = program.getParsedStatement(lineNumber);
  * ----------------------------------------------------------------
  * Retrieves the parsed representation of the statement at the
- * specified line number.  If no value has been set, this method
- * returns NULL.
+ * specified line number, parsing the line first if necessary.  If no
+ * such line exists, this method returns NULL.
  */
 
     Statement *getParsedStatement(int lineNumber);
 
 /*
  * Method: getFirstLineNumber
- * Usage: int lineNumber = program.getFirstLineNumber();+
+ * Usage: int lineNumber = program.getFirstLineNumber();
  * -----------------------------------------------------
  * Returns the line number of the first line in the program.
  * If the program has no lines, this method returns -1.
@@ -138,27 +237,152 @@ public:
  * in the program.  If no more lines remain, this method returns -1.
  */
 
-    int getNextLineNumber();
+    int getNextLineNumber(int lineNumber);
+
+/*
+ * Methods: start, advance, stop
+ * Usage: program.start();
+ *        program.advance();
+ *        program.stop();
+ * ------------------------------
+ * These methods move the execution cursor.  start places it on the
+ * first line, advance moves it to the following line (unless a jump
+ * has just been made) and stop moves it past the last line.
+ */
+
+    void start();
 
-    //more func to add
-    //todo
+    void advance();
 
-    int getNowLineNumber() const;
+    void stop();
 
-    void changeNowLineNumber(int lineNumber);
+/*
+ * Method: jumpTo
+ * Usage: if (!program.jumpTo(lineNumber)) . . .
+ * ---------------------------------------------
+ * Moves the execution cursor to the specified line, which will be
+ * executed next.  If no such line exists, this method returns false
+ * and leaves the cursor unchanged.
+ */
 
-    void addTemporaryLine(Statement *Stmt);
+    bool jumpTo(int lineNumber);
+
+/*
+ * Method: getCurrentStatement
+ * Usage: Statement *stmt = program.getCurrentStatement();
+ * -------------------------------------------------------
+ * Returns the statement under the execution cursor, or NULL if the
+ * cursor has moved past the last line.  A line that has not been
+ * parsed yet is parsed here.
+ */
+
+    Statement *getCurrentStatement();
 
 private:
 
-    // Fill this in with whatever types and instance variables you need
-    //todo
+/*
+ * Type: ProgramLine
+ * -----------------
+ * One entry in the line table.
+ */
+
+    struct ProgramLine {
+        int lineNumber;
+        int length;              /* -1 if the text is canonical */
+        std::size_t offset;
+        bool parsed;             /* false until stmt is filled in */
+        Statement stmt;
+    };
+
+/*
+ * Types: LineChunk, LineTable, Position
+ * -------------------------------------
+ * The line table is a vector of chunks, none of them empty, and a
+ * line is identified by the index of its chunk and its index within
+ * the chunk.  The position past the last line has the chunk index
+ * lines.size().
+ */
+
+    typedef std::vector<ProgramLine, AccountingAllocator<ProgramLine, STATEMENT_MEMORY>> LineChunk;
+
+    typedef std::vector<LineChunk, AccountingAllocator<LineChunk, STATEMENT_MEMORY>> LineTable;
+
+    struct Position {
+        std::size_t chunk;
+        std::size_t index;
+    };
+
+    LineTable lines;
+    std::size_t lineCount = 0;
+    std::vector<LineTable, AccountingAllocator<LineTable, STATEMENT_MEMORY>> retired;   /* Tables dropped by clear */
+    AccountedString pool;
+    std::size_t garbage = 0;
+    Position cursor = {0, 0};
+    bool jumped = false;
+    LineParser lineParser = nullptr;
+
+/*
+ * Methods: find, findLine
+ * -----------------------
+ * find returns the position of the first line whose number is at
+ * least the specified one, or the position past the last line if
+ * there is none.  findLine returns the line with exactly that number,
+ * or NULL if there is none.
+ */
+
+    Position find(int lineNumber) const;
+
+    ProgramLine *findLine(int lineNumber);
+
+/*
+ * Method: splitChunk
+ * ------------------
+ * Moves the upper half of an overfull chunk into a new chunk after
+ * it.  If there is no memory for the new chunk, the chunk simply
+ * stays as it is.
+ */
+
+    void splitChunk(std::size_t chunk);
+
+/*
+ * Method: allocateChunks
+ * ----------------------
+ * Returns a table of empty chunks with room for count lines, filling
+ * every chunk but the last to CHUNK_LINES.  mergeLines allocates the
+ * whole table this way before moving any line into it.
+ */
+
+    static LineTable allocateChunks(std::size_t count);
+
+/*
+ * Methods: insertLine, parseLine
+ * ------------------------------
+ * insertLine puts a line whose text is already stored into the table,
+ * replacing any line with the same number.  parseLine fills in the
+ * statement of a line added by addUnparsedLine.
+ */
+
+    void insertLine(ProgramLine &newLine);
+
+    void parseLine(ProgramLine &line);
+
+/*
+ * Methods: storeSource, canonicalSource, releaseSource, compact
+ * -------------------------------------------------------------
+ * storeSource appends the text to the pool and records it in the
+ * line unless it matches canonicalSource, which prints the line
+ * from its statement.  releaseSource marks the text of the line as
+ * garbage, and compact rebuilds the pool with only the live text
+ * when enough garbage has piled up.
+ */
+
+    void storeSource(ProgramLine &line, std::string_view text);
+
+    std::string canonicalSource(const ProgramLine &line) const;
+
+    void releaseSource(const ProgramLine &line);
 
-    std::set<int> line_list;
-    std::unordered_map<int, std::string> source_line;
-    std::unordered_map<int, Statement*> parsed_line;
-    int nowLineNumber;
-    std::vector<Statement*> temporary_line;
+    void compact();
 
 };
 
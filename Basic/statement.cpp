@@ -1,157 +1,381 @@
 /*
  * File: statement.cpp
  * -------------------
- * This file implements the constructor and destructor for
- * the Statement class itself.  Your implementation must do
- * the same for the subclasses you define for each of the
- * BASIC statements.
+ * This file implements the statement classes declared in
+ * statement.h and the switch that dispatches on a Statement.
  */
 
 #include "statement.hpp"
+#include "program.hpp"
+#include "cache.hpp"
+#include "Utils/inputBuffer.hpp"
+#include "Utils/outputBuffer.hpp"
 
+#include <climits>
 #include <utility>
 
 
-/* Implementation of the Statement class */
+/* Implementation of the statement classes */
 
 int stringToInt(std::string str);
 
-Statement::Statement() = default;
+/*
+ * Implementation notes: expToString
+ * ---------------------------------
+ * Prints an expression in canonical form.  The prec argument is the
+ * lowest operator precedence that may appear without parentheses.
+ * Since the parser groups operators of equal precedence to the left,
+ * the right operand of a compound expression needs parentheses at
+ * its own precedence while the left one does not.
+ */
 
-Statement::~Statement() = default;
+static std::string expToString(const Expression *exp, int prec) {
+    if (exp->getType() != COMPOUND) {
+        return exp->toString();
+    }
+    const CompoundExp *compound = (const CompoundExp *) exp;
+    int opPrec = precedence(compound->getOp());
+    std::string str = expToString(compound->getLHS(), opPrec) + ' ' + compound->getOp() + ' '
+                      + expToString(compound->getRHS(), opPrec + 1);
+    if (opPrec < prec) {
+        return '(' + str + ')';
+    }
+    return str;
+}
 
 //todo
 
-LetStmt::LetStmt(Expression *exp) : exp(exp) {}
+LetStmt::LetStmt(std::unique_ptr<Expression> exp) : exp(shareExpression(std::move(exp))) {}
 
 void LetStmt::execute(EvalState &state, Program &program) {
     exp->eval(state);
 }
 
-LetStmt::~LetStmt() {
-    delete exp;
+std::string LetStmt::toString() const {
+    return "LET " + expToString(exp.get(), 0);
 }
 
-PrintStmt::PrintStmt(Expression *exp) : exp(exp) {}
+PrintStmt::PrintStmt(std::unique_ptr<Expression> exp) : exp(shareExpression(std::move(exp))) {}
 
 void PrintStmt::execute(EvalState &state, Program &program) {
-    std::cout << exp->eval(state) << '\n';
+    standardOutput() << exp->eval(state) << '\n';
 }
 
-PrintStmt::~PrintStmt() {
-    delete exp;
+std::string PrintStmt::toString() const {
+    return "PRINT " + expToString(exp.get(), 2);
 }
 
-InputStmt::InputStmt(IdentifierExp *valName) : valName(valName) {}
+InputStmt::InputStmt(std::unique_ptr<IdentifierExp> valName) : valName(shareExpression(std::move(valName))) {}
+
+/*
+ * Implementation notes: InputStmt
+ * -------------------------------
+ * An answer is an optional minus sign followed by digits, with nothing
+ * else on the line.  An empty answer, like the end of the input, reads
+ * as 0.  Anything else, including a number outside the range of int,
+ * is reported as INVALID NUMBER and the question is asked again.
+ */
+
+static bool readAnswer(std::string_view line, int &value) {
+    bool negative = !line.empty() && line[0] == '-';
+    unsigned limit = INT_MAX + (negative ? 1u : 0u);
+    unsigned magnitude = 0;
+    for (std::size_t i = negative ? 1 : 0; i < line.size(); i++) {
+        if (!isdigit((unsigned char) line[i])) return false;
+        unsigned digit = line[i] - '0';
+        if (magnitude > (limit - digit) / 10) return false;
+        magnitude = magnitude * 10 + digit;
+    }
+    value = negative ? int(0u - magnitude) : int(magnitude);
+    return true;
+}
 
 void InputStmt::execute(EvalState &state, Program &program) {
-    int value = 0, sign = 1;
-    bool flag = false;
-    std::string tmp_in;
+    int value = 0;
     while (true) {
-        value = 0;
-        sign = 1;
-        flag = false;
-        std::cout << " ? ";
-        getline(std::cin, tmp_in);
-        for (int i = 0; i < tmp_in.size(); i++) {
-            if (isdigit(tmp_in[i])) {
-                value = value * 10 + (tmp_in[i] - '0');
-            } else if (tmp_in[i] == '-' && i == 0) {
-                sign = -1;
-            } else {
-                flag = true;
-                break;
-            }
-        }
-        if (flag) {
-            std::cout << "INVALID NUMBER\n";
-            continue;
+        if (state.isPrompting()) {
+            standardOutput() << " ? ";
+            standardOutput().sync();
         }
-        break;
+        std::string_view line;
+        standardInput().readLine(line);
+        if (readAnswer(line, value)) break;
+        standardOutput() << "INVALID NUMBER\n";
+    }
+    state.setValue(valName->getName(), value);
+}
+
+std::string InputStmt::toString() const {
+    return "INPUT " + valName->getName();
+}
+
+OpenStmt::OpenStmt(std::string path, FileMode mode, int channel)
+        : path(std::move(path)), mode(mode), channel(channel) {}
+
+void OpenStmt::execute(EvalState &state, Program &program) {
+    state.openChannel(channel, path, mode);
+}
+
+std::string OpenStmt::toString() const {
+    static const char *const MODE_NAMES[] = {"INPUT", "OUTPUT", "APPEND"};
+    return "OPEN \"" + path + "\" FOR " + MODE_NAMES[mode] + " AS #" + integerToString(channel);
+}
+
+CloseStmt::CloseStmt(int channel) : channel(channel) {}
+
+void CloseStmt::execute(EvalState &state, Program &program) {
+    if (channel == 0) {
+        state.closeChannels();
+    } else {
+        state.closeChannel(channel);
     }
-    value *= sign;
+}
+
+std::string CloseStmt::toString() const {
+    if (channel == 0) return "CLOSE";
+    return "CLOSE #" + integerToString(channel);
+}
+
+PrintFileStmt::PrintFileStmt(int channel, std::unique_ptr<Expression> exp)
+        : exp(shareExpression(std::move(exp))), channel(channel) {}
+
+void PrintFileStmt::execute(EvalState &state, Program &program) {
+    int value = exp->eval(state);
+    state.getOutputChannel(channel) << value << '\n';
+}
+
+std::string PrintFileStmt::toString() const {
+    return "PRINT #" + integerToString(channel) + ", " + expToString(exp.get(), 2);
+}
+
+InputFileStmt::InputFileStmt(int channel, std::unique_ptr<IdentifierExp> valName)
+        : valName(shareExpression(std::move(valName))), channel(channel) {}
+
+/*
+ * Implementation notes: InputFileStmt
+ * -----------------------------------
+ * Each line of the file holds one number, written as INPUT expects
+ * its answers.  The number is converted where it lies in the buffer
+ * of the file.  Since there is nobody to ask again, a malformed number
+ * and reading past the end of the file are errors.
+ */
+
+void InputFileStmt::execute(EvalState &state, Program &program) {
+    std::string_view line;
+    if (!state.getInputChannel(channel).readLine(line)) error("END OF FILE");
+    int value = 0;
+    if (!readAnswer(line, value)) error("INVALID NUMBER");
     state.setValue(valName->getName(), value);
 }
 
-InputStmt::~InputStmt() {
-    delete valName;
+std::string InputFileStmt::toString() const {
+    return "INPUT #" + integerToString(channel) + ", " + valName->getName();
 }
 
 void EndStmt::execute(EvalState &state, Program &program) {
-    program.changeNowLineNumber(-1);
+    program.stop();
+}
+
+std::string EndStmt::toString() const {
+    return "END";
 }
 
 void QuitStmt::execute(EvalState &state, Program &program) {
     program.clear();
     state.Clear();
+    state.closeChannels();
+    program.reclaim(-1);
+    state.reclaim(-1);
 }
 
 void HelpStmt::execute(EvalState &state, Program &program) {
-    std::cout << "What you have said is right, "
-              << "but Basic-Interpreter-2023 is a new open world adventure game developed in-house by ACM-Class-2023."
-              << '\n';
+    standardOutput() << "What you have said is right, "
+                     << "but Basic-Interpreter-2023 is a new open world adventure game developed in-house by ACM-Class-2023."
+                     << '\n';
 }
 
 void ListStmt::execute(EvalState &state, Program &program) {
-    program.changeNowLineNumber(program.getFirstLineNumber());
-    while (program.getNowLineNumber() != -1) {
-        std::cout << program.getSourceLine(program.getNowLineNumber()) << '\n';
-        program.changeNowLineNumber(program.getNextLineNumber());
+    program.writeSource(standardOutput());
+}
+
+StatsStmt::StatsStmt(bool json, const ParseCache &cache) : json(json), cache(cache) {}
+
+void StatsStmt::execute(EvalState &state, Program &program) {
+    struct Figure {
+        const char *name;
+        const char *key;
+        long long value;
+    };
+    Figure figures[] = {
+            {"LINES",            "lines",            program.getLineCount()},
+            {"VARIABLES",        "variables",        state.getVariableCount()},
+            {"CONSTANT NODES",   "constant_nodes",   Expression::getNodeCount(CONSTANT)},
+            {"IDENTIFIER NODES", "identifier_nodes", Expression::getNodeCount(IDENTIFIER)},
+            {"COMPOUND NODES",   "compound_nodes",   Expression::getNodeCount(COMPOUND)},
+            {"EXPRESSION BYTES", "expression_bytes", (long long) getMemoryUsage(EXPRESSION_MEMORY)},
+            {"STATEMENT BYTES",  "statement_bytes",  (long long) getMemoryUsage(STATEMENT_MEMORY)},
+            {"SOURCE BYTES",     "source_bytes",     (long long) getMemoryUsage(SOURCE_MEMORY)},
+            {"SYMBOL BYTES",     "symbol_bytes",     (long long) getMemoryUsage(SYMBOL_MEMORY)},
+            {"CACHE ENTRIES",    "cache_entries",    (long long) cache.getEntryCount()},
+            {"CACHE HITS",       "cache_hits",       cache.getHits()},
+            {"CACHE MISSES",     "cache_misses",     cache.getMisses()},
+            {"CACHE BYTES",      "cache_bytes",      (long long) getMemoryUsage(CACHE_MEMORY)},
+            {"FILE BYTES",       "file_bytes",       (long long) getMemoryUsage(FILE_MEMORY)},
+            {"TOTAL BYTES",      "total_bytes",      (long long) getMemoryUsage()},
+            {"QUOTA BYTES",      "quota_bytes",      (long long) getMemoryQuota()},
+    };
+    OutputBuffer &out = standardOutput();
+    if (json) {
+        out << '{';
+        bool first = true;
+        for (const Figure &figure: figures) {
+            if (!first) out << ',';
+            out << '"' << figure.key << "\":" << figure.value;
+            first = false;
+        }
+        out << "}\n";
+        return;
+    }
+    for (const Figure &figure: figures) {
+        out << figure.name << ": " << figure.value << '\n';
     }
 }
 
 void ClearStmt::execute(EvalState &state, Program &program) {
     program.clear();
     state.Clear();
+    state.closeChannels();
 }
 
-IfStmt::IfStmt(Expression *lhs, std::string cmp, Expression *rhs, int toLineNumber) : lhs(lhs), cmp(std::move(cmp)), rhs(rhs), toLineNumber(toLineNumber) {}
+IfStmt::IfStmt(std::unique_ptr<Expression> lhs, char cmp, std::unique_ptr<Expression> rhs, int toLineNumber)
+        : lhs(shareExpression(std::move(lhs))), rhs(shareExpression(std::move(rhs))), cmp(cmp), toLineNumber(toLineNumber) {}
 
 void IfStmt::execute(EvalState &state, Program &program) {
     int lhsValue = lhs->eval(state);
     int rhsValue = rhs->eval(state);
     bool flag;
-    if (cmp == "=") {
+    if (cmp == '=') {
         flag = (lhsValue == rhsValue);
-    } else if (cmp == ">") {
+    } else if (cmp == '>') {
         flag = (lhsValue > rhsValue);
     } else {
         flag = (lhsValue < rhsValue);
     }
-    if (flag) {
-        if (program.getParsedStatement(toLineNumber) == nullptr) {
-            std::cout << "LINE NUMBER ERROR\n";
-            return;
-        }
-        program.changeNowLineNumber(toLineNumber);
-        program.getParsedStatement(program.getNowLineNumber())->execute(state, program);
+    if (flag && !program.jumpTo(toLineNumber)) {
+        standardOutput() << "LINE NUMBER ERROR\n";
     }
 }
 
-IfStmt::~IfStmt() {
-    delete lhs;
-    delete rhs;
+std::string IfStmt::toString() const {
+    return "IF " + expToString(lhs.get(), 2) + ' ' + cmp + ' ' + expToString(rhs.get(), 2)
+           + " THEN " + integerToString(toLineNumber);
 }
 
 GoToStmt::GoToStmt(int toLineNumber) : toLineNumber(toLineNumber) {}
 
 void GoToStmt::execute(EvalState &state, Program &program) {
-    if (program.getParsedStatement(toLineNumber) == nullptr) {
-        std::cout << "LINE NUMBER ERROR\n";
-        return;
+    if (!program.jumpTo(toLineNumber)) {
+        standardOutput() << "LINE NUMBER ERROR\n";
     }
-    program.changeNowLineNumber(toLineNumber);
-    program.getParsedStatement(program.getNowLineNumber())->execute(state, program);
 }
 
+std::string GoToStmt::toString() const {
+    return "GOTO " + integerToString(toLineNumber);
+}
+
+/*
+ * Implementation notes: RunStmt
+ * -----------------------------
+ * The program lines are stored in line-number order, so RUN simply
+ * walks the line table with the program's cursor.  GOTO and IF move
+ * the cursor to their target line, which is then executed next
+ * instead of the following line.
+ */
+
 void RunStmt::execute(EvalState &state, Program &program) {
-    program.changeNowLineNumber(program.getFirstLineNumber());
-    while (program.getNowLineNumber() != -1) {
-        program.getParsedStatement(program.getNowLineNumber())->execute(state, program);
-        program.changeNowLineNumber(program.getNextLineNumber());
+    program.start();
+    while (Statement *stmt = program.getCurrentStatement()) {
+        executeStatement(*stmt, state, program);
+        program.advance();
     }
 }
 
 void RemStmt::execute(EvalState &state, Program &program) {
 }
+
+std::string RemStmt::toString() const {
+    return "REM";
+}
+
+/*
+ * Implementation notes: executeStatement
+ * --------------------------------------
+ * The switch on the variant index replaces the virtual call that
+ * was used when every statement was a separate heap object.
+ */
+
+void executeStatement(Statement &stmt, EvalState &state, Program &program) {
+    switch (stmt.index()) {
+        case REM_STMT:
+            std::get<REM_STMT>(stmt).execute(state, program);
+            break;
+        case LET_STMT:
+            std::get<LET_STMT>(stmt).execute(state, program);
+            break;
+        case PRINT_STMT:
+            std::get<PRINT_STMT>(stmt).execute(state, program);
+            break;
+        case INPUT_STMT:
+            std::get<INPUT_STMT>(stmt).execute(state, program);
+            break;
+        case END_STMT:
+            std::get<END_STMT>(stmt).execute(state, program);
+            break;
+        case GOTO_STMT:
+            std::get<GOTO_STMT>(stmt).execute(state, program);
+            break;
+        case IF_STMT:
+            std::get<IF_STMT>(stmt).execute(state, program);
+            break;
+        case OPEN_STMT:
+            std::get<OPEN_STMT>(stmt).execute(state, program);
+            break;
+        case CLOSE_STMT:
+            std::get<CLOSE_STMT>(stmt).execute(state, program);
+            break;
+        case PRINT_FILE_STMT:
+            std::get<PRINT_FILE_STMT>(stmt).execute(state, program);
+            break;
+        case INPUT_FILE_STMT:
+            std::get<INPUT_FILE_STMT>(stmt).execute(state, program);
+            break;
+    }
+}
+
+std::string statementToString(const Statement &stmt) {
+    switch (stmt.index()) {
+        case REM_STMT:
+            return std::get<REM_STMT>(stmt).toString();
+        case LET_STMT:
+            return std::get<LET_STMT>(stmt).toString();
+        case PRINT_STMT:
+            return std::get<PRINT_STMT>(stmt).toString();
+        case INPUT_STMT:
+            return std::get<INPUT_STMT>(stmt).toString();
+        case END_STMT:
+            return std::get<END_STMT>(stmt).toString();
+        case GOTO_STMT:
+            return std::get<GOTO_STMT>(stmt).toString();
+        case IF_STMT:
+            return std::get<IF_STMT>(stmt).toString();
+        case OPEN_STMT:
+            return std::get<OPEN_STMT>(stmt).toString();
+        case CLOSE_STMT:
+            return std::get<CLOSE_STMT>(stmt).toString();
+        case PRINT_FILE_STMT:
+            return std::get<PRINT_FILE_STMT>(stmt).toString();
+        case INPUT_FILE_STMT:
+            return std::get<INPUT_FILE_STMT>(stmt).toString();
+    }
+    return "";
+}
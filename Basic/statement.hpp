@@ -1,228 +1,337 @@
 /*
  * File: statement.h
  * -----------------
- * This file defines the Statement abstract type.  In
- * the finished version, this file will also specify subclasses
- * for each of the statement types.  As you design your own
- * version of this class, you should pay careful attention to
- * the exp.h interface, which is an excellent model for
- * the Statement class hierarchy.
+ * This file defines the Statement type.  Unlike Expression, a
+ * Statement is not an abstract class: the statements that can be
+ * stored in a program are plain value classes, and Statement is a
+ * tagged union (std::variant) over them.  This allows the Program
+ * class to keep every statement inline in its line table and to
+ * dispatch on the tag with a switch instead of a virtual call.
  */
 
 #ifndef _statement_h
 #define _statement_h
 
+#include <memory>
 #include <string>
 #include <sstream>
 #include <utility>
+#include <variant>
 #include "evalstate.hpp"
 #include "exp.hpp"
-#include "Utils/tokenScanner.hpp"
-#include "program.hpp"
 #include "parser.hpp"
 #include "Utils/error.hpp"
 #include "Utils/strlib.hpp"
 
 class Program;
 
+class ParseCache;
+
 /*
- * Class: Statement
- * ----------------
- * This class is used to represent a statement in a program.
- * The model for this class is Expression in the exp.h interface.
- * Like Expression, Statement is an abstract class with subclasses
- * for each of the statement and command types required for the
- * BASIC interpreter.
+ * The classes below represent the statements that may appear in
+ * a numbered program line (and, for LET, PRINT, INPUT and the file
+ * statements, also as immediate commands).  Each of them defines a
+ * constructor that takes ownership of the already parsed components,
+ * a method called execute, which executes that statement, and a
+ * method called toString, which returns the statement in canonical
+ * form (without the line number).  The constructors take the
+ * expression trees through std::unique_ptr and turn them into
+ * immutable trees held by std::shared_ptr, so a statement can be
+ * copied cheaply and the copies share their trees, which are freed
+ * with the last copy.
  */
 
-class Statement {
+class LetStmt {
 
 public:
 
-/*
- * Constructor: Statement
- * ----------------------
- * The base class constructor is empty.  Each subclass must provide
- * its own constructor.
- */
-
-    Statement();
+    LetStmt(std::unique_ptr<Expression> exp);
 
-/*
- * Destructor: ~Statement
- * Usage: delete stmt;
- * -------------------
- * The destructor deallocates the storage for this expression.
- * It must be declared virtual to ensure that the correct subclass
- * destructor is called when deleting a statement.
- */
+    void execute(EvalState &state, Program &program);
 
-    virtual ~Statement();
+    std::string toString() const;
 
-/*
- * Method: execute
- * Usage: stmt->execute(state);
- * ----------------------------
- * This method executes a BASIC statement.  Each of the subclasses
- * defines its own execute method that implements the necessary
- * operations.  As was true for the expression evaluator, this
- * method takes an EvalState object for looking up variables or
- * controlling the operation of the interpreter.
- */
+private:
 
-    virtual void execute(EvalState &state, Program &program) = 0;
+    std::shared_ptr<const Expression> exp;
 
 };
 
+class PrintStmt {
 
-/*
- * The remainder of this file must consists of subclass
- * definitions for the individual statement forms.  Each of
- * those subclasses must define a constructor that parses a
- * statement from a scanner and a method called execute,
- * which executes that statement.  If the private data for
- * a subclass includes data allocated on the heap (such as
- * an Expression object), the class implementation must also
- * specify its own destructor method to free that memory.
- */
+public:
+
+    PrintStmt(std::unique_ptr<Expression> exp);
+
+    void execute(EvalState &state, Program &program);
+
+    std::string toString() const;
+
+private:
 
-class LetStmt : public Statement {
+    std::shared_ptr<const Expression> exp;
+
+};
+
+class InputStmt {
 
 public:
 
-    LetStmt(Expression *exp);
+    InputStmt(std::unique_ptr<IdentifierExp> valName);
 
-    void execute(EvalState &state, Program &program) override;
+    void execute(EvalState &state, Program &program);
 
-    ~LetStmt() override;
+    std::string toString() const;
 
 private:
 
-    Expression *exp;
+    std::shared_ptr<const IdentifierExp> valName;
+
+};
+
+class EndStmt {
+
+public:
+
+    void execute(EvalState &state, Program &program);
+
+    std::string toString() const;
 
 };
 
-class PrintStmt : public Statement {
+class GoToStmt {
 
 public:
 
-    PrintStmt(Expression *exp);
+    GoToStmt(int toLineNumber);
 
-    void execute(EvalState &state, Program &program) override;
+    void execute(EvalState &state, Program &program);
 
-    ~PrintStmt();
+    std::string toString() const;
 
 private:
 
-    Expression *exp;
+    int toLineNumber;
 
 };
 
-class InputStmt : public Statement {
+class IfStmt {
 
 public:
 
-    InputStmt(IdentifierExp *valName);
+    IfStmt(std::unique_ptr<Expression> lhs, char cmp, std::unique_ptr<Expression> rhs, int toLineNumber);
 
-    void execute(EvalState &state, Program &program) override;
+    void execute(EvalState &state, Program &program);
 
-    ~InputStmt();
+    std::string toString() const;
 
 private:
 
-    IdentifierExp *valName;
+    std::shared_ptr<const Expression> lhs;
+
+    std::shared_ptr<const Expression> rhs;
+
+    char cmp;
+
+    int toLineNumber;
 
 };
 
-class EndStmt : public Statement {
+class RemStmt {
 
 public:
 
-    void execute(EvalState &state, Program &program) override;
+    void execute(EvalState &state, Program &program);
+
+    std::string toString() const;
 
 };
 
-class RunStmt : public Statement {
+/*
+ * The classes below implement the file statements.  OPEN assigns a
+ * file to one of the channels of the EvalState, PRINT # and INPUT #
+ * write and read that file one number per line, and CLOSE closes it.
+ * A CloseStmt with channel 0 closes every open file.
+ */
+
+class OpenStmt {
 
 public:
 
-    void execute(EvalState &state, Program &program) override;
+    OpenStmt(std::string path, FileMode mode, int channel);
+
+    void execute(EvalState &state, Program &program);
+
+    std::string toString() const;
+
+private:
+
+    std::string path;
+
+    FileMode mode;
+
+    int channel;
 
 };
 
-class ListStmt : public Statement {
+class CloseStmt {
 
 public:
 
-    void execute(EvalState &state, Program &program) override;
+    CloseStmt(int channel);
+
+    void execute(EvalState &state, Program &program);
+
+    std::string toString() const;
+
+private:
+
+    int channel;
 
 };
 
-class GoToStmt : public Statement {
+class PrintFileStmt {
 
 public:
 
-    GoToStmt(int toLineNumber);
+    PrintFileStmt(int channel, std::unique_ptr<Expression> exp);
+
+    void execute(EvalState &state, Program &program);
 
-    void execute(EvalState &state, Program &program) override;
+    std::string toString() const;
 
 private:
 
-    int toLineNumber;
+    std::shared_ptr<const Expression> exp;
+
+    int channel;
 
 };
 
-class IfStmt : public Statement {
+class InputFileStmt {
 
 public:
 
-    IfStmt(Expression *lhs, std::string cmp, Expression *rhs, int toLineNumber);
+    InputFileStmt(int channel, std::unique_ptr<IdentifierExp> valName);
 
-    void execute(EvalState &state, Program &program) override;
+    void execute(EvalState &state, Program &program);
 
-    ~IfStmt();
+    std::string toString() const;
 
 private:
 
-    Expression *lhs;
+    std::shared_ptr<const IdentifierExp> valName;
 
-    std::string cmp;
+    int channel;
 
-    Expression *rhs;
+};
 
-    int toLineNumber;
+/*
+ * Type: Statement
+ * ---------------
+ * A statement stored in a program line.  The alternatives must stay
+ * in the same order as the StatementType constants below, which are
+ * the values returned by stmt.index().
+ */
 
+using Statement = std::variant<RemStmt, LetStmt, PrintStmt, InputStmt, EndStmt, GoToStmt, IfStmt,
+                               OpenStmt, CloseStmt, PrintFileStmt, InputFileStmt>;
+
+enum StatementType {
+    REM_STMT, LET_STMT, PRINT_STMT, INPUT_STMT, END_STMT, GOTO_STMT, IF_STMT,
+    OPEN_STMT, CLOSE_STMT, PRINT_FILE_STMT, INPUT_FILE_STMT
 };
 
-class QuitStmt : public Statement {
+/*
+ * Function: executeStatement
+ * Usage: executeStatement(stmt, state, program);
+ * ----------------------------------------------
+ * Executes the statement by switching on its type tag and calling
+ * the execute method of the stored alternative.
+ */
+
+void executeStatement(Statement &stmt, EvalState &state, Program &program);
+
+/*
+ * Function: statementToString
+ * Usage: std::string str = statementToString(stmt);
+ * -------------------------------------------------
+ * Returns the canonical text of the statement: the keyword and its
+ * operands separated by single spaces, with expressions printed with
+ * only the parentheses their precedence requires.
+ */
+
+std::string statementToString(const Statement &stmt);
+
+/*
+ * The classes below implement the commands that can only be used
+ * in immediate mode.  They have no data of their own and are never
+ * stored in a program.
+ */
+
+class RunStmt {
+
+public:
+
+    void execute(EvalState &state, Program &program);
+
+};
+
+class ListStmt {
+
+public:
+
+    void execute(EvalState &state, Program &program);
+
+};
+
+class QuitStmt {
 
 public:
 
-    void execute(EvalState &state, Program &program) override;
+    void execute(EvalState &state, Program &program);
 
 };
 
-class HelpStmt : public Statement {
+class HelpStmt {
 
 public:
 
-    void execute(EvalState &state, Program &program) override;
+    void execute(EvalState &state, Program &program);
 
 };
 
-class ClearStmt : public Statement {
+class ClearStmt {
 
 public:
 
-    void execute(EvalState &state, Program &program) override;
+    void execute(EvalState &state, Program &program);
 
 };
 
-class RemStmt : public Statement {
+/*
+ * Class: StatsStmt
+ * ----------------
+ * Reports the size of the program, the number of expression nodes of
+ * each type, the number of variables, the use of the parse cache and
+ * the memory charged to each category of the memory account.  STATS
+ * prints one "NAME: value" line per figure, while STATS JSON prints a
+ * single JSON object for use by other programs.
+ */
+
+class StatsStmt {
 
 public:
 
-    void execute(EvalState &state, Program &program) override;
+    StatsStmt(bool json, const ParseCache &cache);
+
+    void execute(EvalState &state, Program &program);
+
+private:
+
+    bool json;
+
+    const ParseCache &cache;
 
 };
 
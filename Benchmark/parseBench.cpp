@@ -0,0 +1,156 @@
+/*
+ * File: parseBench.cpp
+ * --------------------
+ * This program measures the throughput of the front end of the
+ * interpreter on a corpus of BASIC lines, normally the traces in
+ * Test/.  It times three passes over the corpus, each repeated the
+ * given number of times:
+ *
+ *   lex     splits every line into tokens with lexLine
+ *   parse   builds the tree of every expression with readE
+ *   check   checks every expression with checkE
+ *
+ * The expressions of a line are found without the command table: the
+ * line number and the keyword are skipped, and an expression is read
+ * wherever a term can start.  Lines with REM are only lexed.
+ *
+ * Usage: parse_bench [--iterations=N] FILE...
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "parser.hpp"
+#include "Utils/lexer.hpp"
+
+/*
+ * Type: PassResult
+ * ----------------
+ * The totals of one timed pass over the corpus.
+ */
+
+struct PassResult {
+    double seconds = 0;
+    long long tokens = 0;
+    long long expressions = 0;
+    long long errors = 0;
+};
+
+/*
+ * Function: startsExpression
+ * Usage: if (startsExpression(tokens)) ...
+ * ----------------------------------------
+ * Returns true if the token at the cursor can start a term.
+ */
+
+static bool startsExpression(const TokenArray &tokens) {
+    LexemeKind kind = tokens.peekKind();
+    if (kind == LEX_WORD || kind == LEX_NUMBER) return true;
+    std::string_view token = tokens.peekToken();
+    return token == "(" || token == "-";
+}
+
+/*
+ * Function: readExpressions
+ * Usage: readExpressions(tokens, build, result);
+ * ----------------------------------------------
+ * Reads every expression of the line in tokens, with readE if build
+ * is true and with checkE otherwise.
+ */
+
+static void readExpressions(TokenArray &tokens, bool build, PassResult &result) {
+    if (tokens.peekKind() == LEX_NUMBER) tokens.nextToken();
+    if (tokens.peekToken() == "REM") return;
+    if (tokens.peekKind() == LEX_WORD) tokens.nextToken();
+    while (tokens.hasMoreTokens()) {
+        if (!startsExpression(tokens)) {
+            tokens.nextToken();
+            continue;
+        }
+        try {
+            if (build) {
+                readE(tokens);
+            } else {
+                checkE(tokens);
+            }
+            result.expressions++;
+        } catch (ErrorException &ex) {
+            result.errors++;
+        }
+    }
+}
+
+/*
+ * Function: runPass
+ * Usage: PassResult result = runPass(name, lines, iterations);
+ * -------------------------------------------------------------
+ * Runs the named pass over the lines the given number of times and
+ * returns the totals.
+ */
+
+static PassResult runPass(const std::string &name, const std::vector<std::string> &lines, int iterations) {
+    PassResult result;
+    std::vector<Lexeme> lexemes;
+    TokenArray tokens;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        for (const std::string &line: lines) {
+            if (name == "lex") {
+                lexLine(line, lexemes);
+                result.tokens += lexemes.size();
+                continue;
+            }
+            tokens.setInput(line);
+            readExpressions(tokens, name == "parse", result);
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.seconds = elapsed.count();
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    int iterations = 1000;
+    std::vector<std::string> lines;
+    std::size_t bytes = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 13, "--iterations=") == 0) {
+            iterations = std::atoi(arg.c_str() + 13);
+            continue;
+        }
+        std::ifstream file(arg);
+        if (!file) {
+            std::cerr << argv[0] << ": cannot open " << arg << std::endl;
+            return 1;
+        }
+        std::string line;
+        while (std::getline(file, line)) {
+            bytes += line.size() + 1;
+            lines.push_back(line);
+        }
+    }
+    if (lines.empty() || iterations <= 0) {
+        std::cerr << "usage: " << argv[0] << " [--iterations=N] FILE..." << std::endl;
+        return 1;
+    }
+    std::cout << lines.size() << " lines, " << bytes << " bytes, " << iterations << " iterations" << std::endl;
+    for (const char *name: {"lex", "parse", "check"}) {
+        PassResult result = runPass(name, lines, iterations);
+        double mbPerSecond = double(bytes) * iterations / result.seconds / 1e6;
+        double linesPerSecond = double(lines.size()) * iterations / result.seconds / 1e6;
+        std::cout << name << ": " << result.seconds << " s, " << mbPerSecond << " MB/s, "
+                  << linesPerSecond << " Mlines/s";
+        if (result.tokens > 0) std::cout << ", " << result.tokens / result.seconds / 1e6 << " Mtokens/s";
+        if (result.expressions > 0) {
+            std::cout << ", " << result.expressions / result.seconds / 1e6 << " Mexpressions/s ("
+                      << result.errors / iterations << " errors per pass)";
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,86 @@
+/*
+ * File: printBench.cpp
+ * --------------------
+ * This program times the way PRINT writes numbers: it writes count
+ * integers, one per line, through standardOutput, which formats each
+ * of them with formatInteger straight into the output buffer.  The
+ * values step through the whole range of int, so they have every
+ * length and both signs, and every thousandth one is INT_MIN.  With
+ * --compare, the same values are then written through std::cout, the
+ * way PRINT wrote them before.  The timings go to std::cerr, so the
+ * numbers themselves should be sent to /dev/null.
+ *
+ * Before anything is timed, the formatted text of the first million
+ * values, INT_MIN and INT_MAX is checked against std::to_string.
+ *
+ * Usage: print_bench [--count=N] [--compare] > /dev/null
+ */
+
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "Utils/outputBuffer.hpp"
+#include "Utils/strlib.hpp"
+
+/*
+ * Function: valueAt
+ * Usage: int value = valueAt(i);
+ * ------------------------------
+ * Returns the i-th value to print.  Multiplying by an odd constant
+ * modulo 2^32 visits every int, so the values are spread over the
+ * whole range.
+ */
+
+static int valueAt(long long i) {
+    if (i % 1000 == 999) return INT_MIN;
+    return int(uint32_t(i * 2654435761u));
+}
+
+int main(int argc, char *argv[]) {
+    long long count = 100000000;
+    bool compare = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 8, "--count=") == 0 && std::atoll(arg.c_str() + 8) > 0) {
+            count = std::atoll(arg.c_str() + 8);
+        } else if (arg == "--compare") {
+            compare = true;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--count=N] [--compare] > /dev/null" << std::endl;
+            return 1;
+        }
+    }
+
+    char buffer[MAX_INTEGER_CHARS];
+    for (long long i = -2; i < 1000000; i++) {
+        int value = i == -2 ? INT_MIN : i == -1 ? INT_MAX : valueAt(i);
+        if (std::string(buffer, formatInteger(buffer, value)) != std::to_string(value)) {
+            std::cerr << "formatInteger(" << value << ") is wrong" << std::endl;
+            return 1;
+        }
+    }
+
+    OutputBuffer &out = standardOutput();
+    auto start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < count; i++) {
+        out << valueAt(i) << '\n';
+    }
+    out.flush();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cerr << "OutputBuffer: " << count << " integers in " << elapsed.count() << " s, "
+              << count / elapsed.count() / 1e6 << " M/s" << std::endl;
+    if (!compare) return 0;
+
+    start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < count; i++) {
+        std::cout << valueAt(i) << '\n';
+    }
+    std::cout.flush();
+    elapsed = std::chrono::steady_clock::now() - start;
+    std::cerr << "std::cout:    " << count << " integers in " << elapsed.count() << " s, "
+              << count / elapsed.count() / 1e6 << " M/s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * File: strlibBench.cpp
+ * ---------------------
+ * This program times the numeric conversions of strlib against the
+ * stream-based versions they replaced, which are copied below as they
+ * were.  Each routine is run over the same inputs, and the results of
+ * the two versions are compared first, so a run also checks that the
+ * conversions still agree with the old ones.
+ *
+ * Usage: strlib_bench [--iterations=N]
+ */
+
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Utils/error.hpp"
+#include "Utils/strlib.hpp"
+
+/* The stream-based versions of the conversions */
+
+static std::string streamIntegerToString(int n) {
+    std::ostringstream stream;
+    stream << n;
+    return stream.str();
+}
+
+static int streamStringToInteger(std::string str) {
+    std::istringstream stream(str);
+    int value;
+    stream >> value;
+    if (!stream.eof()) stream >> std::ws;
+    if (stream.fail() || !stream.eof()) {
+        error("stringToInteger: Illegal integer format (" + str + ")");
+    }
+    return value;
+}
+
+static std::string streamRealToString(double d) {
+    std::ostringstream stream;
+    stream << std::uppercase << d;
+    return stream.str();
+}
+
+static double streamStringToReal(std::string str) {
+    std::istringstream stream(str);
+    double value;
+    stream >> value;
+    if (!stream.eof()) stream >> std::ws;
+    if (stream.fail() || !stream.eof()) {
+        error("stringToReal: Illegal floating-point format (" + str + ")");
+    }
+    return value;
+}
+
+/*
+ * Function: timeLoop
+ * Usage: double seconds = timeLoop(count, body);
+ * ----------------------------------------------
+ * Calls body with every index below count and returns the time taken.
+ */
+
+static double timeLoop(std::size_t count, const std::function<void(std::size_t)> &body) {
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < count; i++) {
+        body(i);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+/*
+ * Function: report
+ * Usage: report(name, count, oldSeconds, newSeconds);
+ * ---------------------------------------------------
+ * Prints the rates of the two versions of one conversion.
+ */
+
+static void report(const char *name, std::size_t count, double oldSeconds, double newSeconds) {
+    std::cout << name << ": stream " << count / oldSeconds / 1e6 << " M/s, strlib "
+              << count / newSeconds / 1e6 << " M/s, " << oldSeconds / newSeconds << "x" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    std::size_t count = 1000000;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 13, "--iterations=") == 0 && std::atol(arg.c_str() + 13) > 0) {
+            count = std::atol(arg.c_str() + 13);
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--iterations=N]" << std::endl;
+            return 1;
+        }
+    }
+
+    /* The inputs: integers of every length and sign, and reals */
+    std::mt19937 random(42);
+    std::vector<int> integers = {0, 1, -1, 9, 10, -10, INT_MAX, INT_MIN};
+    while (integers.size() < 4096) {
+        int digits = std::uniform_int_distribution<int>(1, 31)(random);
+        int n = int(random() >> (32 - digits));
+        integers.push_back(random() % 2 ? n : -n);
+    }
+    std::vector<double> reals = {0.0, 1.0, -2.5, 1e-300, 1e300, 123456789.0, 0.1};
+    while (reals.size() < 4096) {
+        double mantissa = std::uniform_real_distribution<double>(-10, 10)(random);
+        reals.push_back(mantissa * std::pow(10.0, std::uniform_int_distribution<int>(-12, 12)(random)));
+    }
+    std::vector<std::string> integerTexts, realTexts;
+    for (int n: integers) {
+        integerTexts.push_back(streamIntegerToString(n));
+    }
+    for (double d: reals) {
+        realTexts.push_back(streamRealToString(d));
+    }
+    std::size_t mask = integers.size() - 1;
+
+    /* Check that both versions agree on every input */
+    int mismatches = 0;
+    for (std::size_t i = 0; i < integers.size(); i++) {
+        if (integerToString(integers[i]) != integerTexts[i]) mismatches++;
+        if (stringToInteger(integerTexts[i]) != integers[i]) mismatches++;
+        if (realToString(reals[i]) != realTexts[i]) mismatches++;
+        if (stringToReal(realTexts[i]) != streamStringToReal(realTexts[i])) mismatches++;
+    }
+    if (mismatches != 0) {
+        std::cerr << mismatches << " conversions differ from the stream versions" << std::endl;
+        return 1;
+    }
+
+    long long sink = 0;
+    double oldSeconds, newSeconds;
+    oldSeconds = timeLoop(count, [&](std::size_t i) { sink += streamIntegerToString(integers[i & mask]).size(); });
+    newSeconds = timeLoop(count, [&](std::size_t i) { sink += integerToString(integers[i & mask]).size(); });
+    report("integerToString", count, oldSeconds, newSeconds);
+    oldSeconds = timeLoop(count, [&](std::size_t i) { sink += streamStringToInteger(integerTexts[i & mask]); });
+    newSeconds = timeLoop(count, [&](std::size_t i) { sink += stringToInteger(integerTexts[i & mask]); });
+    report("stringToInteger", count, oldSeconds, newSeconds);
+    oldSeconds = timeLoop(count, [&](std::size_t i) { sink += streamRealToString(reals[i & mask]).size(); });
+    newSeconds = timeLoop(count, [&](std::size_t i) { sink += realToString(reals[i & mask]).size(); });
+    report("realToString", count, oldSeconds, newSeconds);
+    oldSeconds = timeLoop(count, [&](std::size_t i) { sink += (long long) streamStringToReal(realTexts[i & mask]); });
+    newSeconds = timeLoop(count, [&](std::size_t i) { sink += (long long) stringToReal(realTexts[i & mask]); });
+    report("stringToReal", count, oldSeconds, newSeconds);
+    if (sink == 42) std::cout << std::endl;
+    return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * File: lexDump.cpp
+ * -----------------
+ * This program prints the tokens of every line of the given files, as
+ * split by lexLine, separated by single spaces, with a line naming
+ * each file before its tokens.  It also reads each line through a
+ * TokenArray and prints a line starting with '!' wherever the two
+ * disagree.
+ *
+ * With --compare, the output is compared with a file instead of being
+ * printed, and the first line that differs is reported.  The lexer
+ * test compares the tokens of the traces and of edge.txt with
+ * tokens.golden, which was produced from the same files by the
+ * Stanford TokenScanner set up with ignoreWhitespace and scanNumbers,
+ * the scanner that lexLine replaced.
+ *
+ * Usage: lex_dump [--compare=GOLDEN] FILE...
+ */
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Utils/lexer.hpp"
+
+/*
+ * Function: sameTokens
+ * Usage: if (sameTokens(line, lexemes, tokens)) ...
+ * -------------------------------------------------
+ * Returns true if the TokenArray tokens, set to the line, returns the
+ * tokens in lexemes, with the same kinds, and then reports the end of
+ * the line.
+ */
+
+static bool sameTokens(std::string_view line, const std::vector<Lexeme> &lexemes, TokenArray &tokens) {
+    tokens.setInput(line);
+    for (const Lexeme &lexeme: lexemes) {
+        std::string_view text = line.substr(lexeme.offset, lexeme.length);
+        if (!tokens.hasMoreTokens() || tokens.peekToken() != text) return false;
+        if (tokens.peekKind() != lexeme.kind || tokens.getTokenKind(text) != lexeme.kind) return false;
+        if (tokens.nextToken() != text) return false;
+    }
+    return !tokens.hasMoreTokens() && tokens.peekKind() == LEX_END && tokens.nextToken().empty();
+}
+
+/*
+ * Function: compareLines
+ * Usage: bool same = compareLines(output, golden);
+ * ------------------------------------------------
+ * Compares the output with the contents of golden line by line and
+ * reports the first difference on std::cerr.
+ */
+
+static bool compareLines(const std::string &output, std::istream &golden) {
+    std::istringstream actual(output);
+    std::string expected, got;
+    for (int number = 1; ; number++) {
+        bool moreExpected = bool(std::getline(golden, expected));
+        bool moreGot = bool(std::getline(actual, got));
+        if (!moreExpected && !moreGot) return true;
+        if (moreExpected != moreGot || expected != got) {
+            std::cerr << "line " << number << ": expected \"" << (moreExpected ? expected : "<end>")
+                      << "\", got \"" << (moreGot ? got : "<end>") << '"' << std::endl;
+            return false;
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<Lexeme> lexemes;
+    TokenArray tokens;
+    std::string goldenPath;
+    std::ostringstream out;
+    for (int i = 1; i < argc; i++) {
+        std::string path = argv[i];
+        if (path.compare(0, 10, "--compare=") == 0) {
+            goldenPath = path.substr(10);
+            continue;
+        }
+        std::ifstream file(path);
+        if (!file) {
+            std::cerr << argv[0] << ": cannot open " << path << std::endl;
+            return 1;
+        }
+        out << "# " << path.substr(path.rfind('/') + 1) << '\n';
+        std::string line;
+        while (std::getline(file, line)) {
+            lexLine(line, lexemes);
+            for (std::size_t j = 0; j < lexemes.size(); j++) {
+                if (j > 0) out << ' ';
+                out << std::string_view(line).substr(lexemes[j].offset, lexemes[j].length);
+            }
+            out << '\n';
+            if (!sameTokens(line, lexemes, tokens)) out << "! TokenArray differs\n";
+        }
+    }
+    if (goldenPath.empty()) {
+        std::cout << out.str();
+        return 0;
+    }
+    std::ifstream golden(goldenPath);
+    if (!golden) {
+        std::cerr << argv[0] << ": cannot open " << goldenPath << std::endl;
+        return 1;
+    }
+    return compareLines(out.str(), golden) ? 0 : 1;
+}
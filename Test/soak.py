@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+#
+# File: soak.py
+# -------------
+# Pipes a long session into the interpreter and checks that its peak
+# resident set size does not grow with the length of the session.
+# Each round replaces the numbered lines of a small program in place,
+# runs it, answers its INPUT, and enters immediate LET, PRINT and
+# INPUT commands.  The expressions change from round to round, so
+# statements and trees are really built and freed, and the parse
+# cache stays full.  The first hundred rounds also end with CLEAR.
+# CLEAR is left out of the later rounds because it frees everything,
+# which would hide a leak between two CLEARs.  A session ten times as
+# long should peak at about the same size as a short one.
+#
+# Usage: soak.py INTERPRETER [ROUNDS]
+
+import os
+import sys
+import tempfile
+
+# The growth allowed between the short and the long run, in KiB.
+SLACK_KIB = 1024
+
+
+def peak_rss(interpreter, rounds):
+    """Runs the interpreter on the given number of rounds and returns
+    its peak resident set size in KiB."""
+    with tempfile.TemporaryFile() as script:
+        for i in range(rounds):
+            v = "x%d" % (i % 64)
+            script.write(b"10 LET %s = %d * 2 + 1\n" % (v.encode(), i))
+            script.write(b"20 PRINT %s - %d\n" % (v.encode(), i))
+            script.write(b"30 INPUT y\n40 PRINT y + %d\n50 END\nRUN\n%d\n" % (i, i))
+            script.write(b"LET z = %d * (3 + %s)\nPRINT z - %d\n" % (i, v.encode(), i))
+            script.write(b"INPUT w\n%d\n" % i)
+            if i < 100:
+                script.write(b"CLEAR\n")
+        script.seek(0)
+        pid = os.fork()
+        if pid == 0:
+            os.dup2(script.fileno(), 0)
+            devnull = os.open(os.devnull, os.O_WRONLY)
+            os.dup2(devnull, 1)
+            os.execv(interpreter, [interpreter])
+        _, status, usage = os.wait4(pid, 0)
+    if status != 0:
+        sys.exit("%s exited with status %d" % (interpreter, status))
+    return usage.ru_maxrss
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit("usage: soak.py INTERPRETER [ROUNDS]")
+    interpreter = sys.argv[1]
+    rounds = int(sys.argv[2]) if len(sys.argv) > 2 else 5000
+    short = peak_rss(interpreter, rounds)
+    long = peak_rss(interpreter, rounds * 10)
+    print("%d rounds: %d KiB, %d rounds: %d KiB" % (rounds, short, rounds * 10, long))
+    if long > short + SLACK_KIB:
+        sys.exit("peak RSS grew by %d KiB" % (long - short))
+
+
+if __name__ == "__main__":
+    main()